@@ -1,6 +1,7 @@
 #include "Compiler.hpp"
+#include "vm/VM.hpp"
 
-Compiler::Compiler() {}
+Compiler::Compiler(VM* vm) : vm(vm) {}
 
 Compiler::~Compiler() {}
 
@@ -21,3 +22,41 @@ jit_label_t* Compiler::get_current_loop_end_label() const {
 jit_label_t* Compiler::get_current_loop_cond_label() const {
 	return loops_cond_labels.back();
 }
+
+void Compiler::enter_function() {
+	function_vars.push_back({});
+}
+
+void Compiler::leave_function() {
+	function_vars.pop_back();
+}
+
+void Compiler::add_function_var(jit_value_t var) {
+	function_vars.back().push_back(var);
+}
+
+bool Compiler::is_function_var(jit_value_t var) const {
+	for (jit_value_t v : function_vars.back()) {
+		if (v == var) return true;
+	}
+	return false;
+}
+
+/*
+ * Release the variables of the current function. The returned value
+ * (if it's a pointer) is kept alive as a temporary for the caller.
+ */
+void Compiler::delete_function_vars(jit_function_t& F, jit_value_t res) const {
+	if (function_vars.back().empty()) {
+		return;
+	}
+	if (res != nullptr) {
+		VM::inc_refs(F, res);
+	}
+	for (jit_value_t v : function_vars.back()) {
+		VM::delete_ref(F, v);
+	}
+	if (res != nullptr) {
+		VM::dec_refs(F, res);
+	}
+}
@@ -3,14 +3,62 @@
 
 #include <jit/jit.h>
 #include <vector>
+#include <map>
+#include <string>
+#include "vm/Type.hpp"
 
+class LoopMotion;
+class SemanticVar;
+class VM;
+
+/*
+ * State of the compilation of a program : each compilation has its own,
+ * so that several programs can be compiled at once
+ */
 class Compiler {
 public:
 
+	// VM the program is compiled for
+	VM* vm;
+
+	/*
+	 * Jit values of the variables : the internal values of the program
+	 * (system classes), the global variables and their types, and the
+	 * local variables of the function being compiled
+	 */
+	std::map<std::string, jit_value_t> internals;
+	std::map<std::string, jit_value_t> globals;
+	std::map<std::string, Type> globals_types;
+	std::map<std::string, jit_value_t> locals;
+
 	std::vector<jit_label_t*> loops_end_labels;
 	std::vector<jit_label_t*> loops_cond_labels;
 
-	Compiler();
+	/*
+	 * Pointer variables owned by each function being compiled,
+	 * released when the function returns
+	 */
+	std::vector<std::vector<jit_value_t>> function_vars;
+
+	/*
+	 * Values of the parameters of the lambda whose body is being compiled
+	 * inline in the current function, nullptr in the body of a function
+	 */
+	std::vector<jit_value_t>* inlined_arguments = nullptr;
+
+	/*
+	 * Invariants and induction expressions of the loops being compiled
+	 * in the current function, the innermost last
+	 */
+	std::vector<LoopMotion*> loop_motions;
+
+	/*
+	 * Elements of the array and object literals of the variables replaced
+	 * by their elements (see SemanticVar::scalar_replaced)
+	 */
+	std::map<const SemanticVar*, std::vector<jit_value_t>> scalar_elements;
+
+	Compiler(VM* vm);
 	virtual ~Compiler();
 
 	void enter_loop(jit_label_t*, jit_label_t*);
@@ -18,6 +66,13 @@ public:
 
 	jit_label_t* get_current_loop_end_label() const;
 	jit_label_t* get_current_loop_cond_label() const;
+
+	void enter_function();
+	void leave_function();
+
+	void add_function_var(jit_value_t);
+	bool is_function_var(jit_value_t) const;
+	void delete_function_vars(jit_function_t&, jit_value_t) const;
 };
 
 #endif
@@ -5,9 +5,14 @@
 #include <algorithm>
 #include <iterator>
 #include <string>
+#include <vector>
 #include "vm/VM.hpp"
+#include "vm/Server.hpp"
+#include "vm/Context.hpp"
+#include "parser/lexical/TokenFile.hpp"
 #include "test/Test.hpp"
 #include "vm/doc/Documentation.hpp"
+#include "benchmark/Benchmark.hpp"
 
 using namespace std;
 
@@ -15,6 +20,8 @@ bool param_time = false;
 bool param_verbose = false;
 bool param_exec = false;
 bool param_file = false;
+bool param_compile = false;
+bool param_snapshot = false;
 
 int main(int argc, char* argv[]) {
 
@@ -24,11 +31,80 @@ int main(int argc, char* argv[]) {
 		return 0;
 	}
 
+	if (argc > 1 && string(argv[1]) == "-benchmark") {
+		Benchmark().array_kernels();
+		return 0;
+	}
+
 	if (argc > 1 && string(argv[1]) == "-doc") {
 		Documentation().generate(cout);
 		return 0;
 	}
 
+	/*
+	 * Batch : executes the jobs of a file (one JSON object by line) on all
+	 * the cores, and prints their results in order, one by line
+	 */
+	if (argc > 2 && string(argv[1]) == "-batch") {
+
+		ifstream ifs(argv[2]);
+		if (!ifs.is_open()) {
+			cout << "Can't open " << argv[2] << endl;
+			return 1;
+		}
+		vector<Job> jobs;
+		vector<bool> valid;
+		string line;
+		while (getline(ifs, line)) {
+			if (line.empty()) continue;
+			Job job;
+			valid.push_back(Job::parse(line, job));
+			if (valid.back()) jobs.push_back(job);
+		}
+		ifs.close();
+
+		// The output of the programs (print) goes to the error output,
+		// the standard output only gets the results
+		ostream output(cout.rdbuf());
+		cout.rdbuf(cerr.rdbuf());
+		VM vm;
+		vector<string> results = vm.execute_batch(jobs);
+		cout.rdbuf(output.rdbuf());
+		size_t r = 0;
+		for (bool v : valid) {
+			if (v) {
+				cout << results[r++] << endl;
+			} else {
+				cout << "{\"success\":false,\"errors\":[{\"message\":\"Invalid job\"}]}" << endl;
+			}
+		}
+		return 0;
+	}
+
+	/*
+	 * Server : answers the jobs read on the standard input, or on the
+	 * connections of a local socket
+	 */
+	if (argc > 1 && string(argv[1]) == "-server") {
+
+		VM vm;
+		Server server(vm);
+		if (argc > 2) {
+			if (!server.listen(argv[2])) {
+				cout << "Can't listen on " << argv[2] << endl;
+				return 1;
+			}
+			return 0;
+		}
+		// The output of the programs (print) goes to the error output,
+		// the standard output only gets the results
+		ostream results(cout.rdbuf());
+		cout.rdbuf(cerr.rdbuf());
+		server.serve(cin, results);
+		cout.rdbuf(results.rdbuf());
+		return 0;
+	}
+
 	/*
 	 * Arguments
 	 */
@@ -39,18 +115,48 @@ int main(int argc, char* argv[]) {
 			else if (c == 'v') param_verbose = true;
 			else if (c == 'e') param_exec = true;
 			else if (c == 'f') param_file = true;
+			else if (c == 'c') param_compile = true;
+			else if (c == 's') param_snapshot = true;
 		}
 	}
 
 	string code;
 	VM vm;
 
-	if (param_file) {
+	if (param_compile) {
+
+		// Precompile the .ls files given into .lsc files
+		for (int i = 2; i < argc; ++i) {
+
+			string file = argv[i];
+			ifstream ifs(file.data());
+			if (!ifs.is_open()) {
+				cout << "Can't open " << file << endl;
+				return 1;
+			}
+			code = string((istreambuf_iterator<char>(ifs)), (istreambuf_iterator<char>()));
+			ifs.close();
+
+			string compiled = file + "c";
+			if (!TokenFile::save(compiled, code)) {
+				cout << "Can't precompile " << file << endl;
+				return 1;
+			}
+			cout << file << " => " << compiled << endl;
+		}
+
+	} else if (param_file) {
 
 		string file("");
 		if (argc > 2) file = argv[2];
 		if (argc == 2 && argv[1][0] != '-') file = argv[1];
 
+		// Precompiled file
+		if (file.size() > 4 && file.substr(file.size() - 4) == ".lsc") {
+			vm.execute_file(file, "{}", ExecMode::NORMAL);
+			return 0;
+		}
+
 		// Read file
 		ifstream ifs(file.data());
 		code = string((istreambuf_iterator<char>(ifs)), (istreambuf_iterator<char>()));
@@ -69,7 +175,18 @@ int main(int argc, char* argv[]) {
 	} else {
 
 		cout << "~~~ LeekScript v1.0 ~~~" << endl;
-		string ctx = "{}";
+
+		// The globals stay in a live context, restored from a snapshot
+		// and saved in it at the end with -s
+		Context context;
+		string snapshot = param_snapshot && argc > 2 ? argv[2] : "";
+		if (!snapshot.empty()) {
+			ifstream ifs(snapshot, ios::binary);
+			if (ifs.is_open() && !context.load(ifs)) {
+				cout << "Can't load the snapshot " << snapshot << endl;
+				return 1;
+			}
+		}
 
 		while (!std::cin.eof()) {
 
@@ -78,7 +195,15 @@ int main(int argc, char* argv[]) {
 			std::getline(std::cin, code);
 
 			// Execute
-			ctx = vm.execute(code, ctx, ExecMode::TOP_LEVEL);
+			vm.execute(code, context, ExecMode::TOP_LEVEL);
+		}
+
+		if (!snapshot.empty()) {
+			ofstream ofs(snapshot, ios::binary);
+			if (!context.save(ofs)) {
+				cout << "Can't save the snapshot " << snapshot << endl;
+				return 1;
+			}
 		}
 	}
 	return 0;
@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <iterator>
 #include <string>
+#include <functional>
+#include "../vm/standard/ArrayKernels.hpp"
 using namespace std;
 
 Benchmark::Benchmark() {}
@@ -39,3 +41,54 @@ void primes() {
 	double elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
 	cout << "primes time : " << elapsed_secs * 1000 << "ms" << endl;
 }
+
+/*
+ * Times the versions of the array kernels supported by the processor on
+ * large arrays : the scalar one is the reference
+ */
+void Benchmark::array_kernels() {
+
+	const size_t size = 1000000;
+	const int runs = 200;
+	vector<int> ints(size);
+	vector<double> reals(size);
+	for (size_t i = 0; i < size; ++i) {
+		ints[i] = (int) ((i * 7919) % 1000003) - 500000;
+		reals[i] = ints[i] * 0.5;
+	}
+	vector<const ArrayKernels*> kernels = ArrayKernels::supported();
+
+	auto measure = [&](string name, function<double(const ArrayKernels&)> run) {
+		cout << name << " :";
+		double reference = 0;
+		for (const ArrayKernels* k : kernels) {
+			double result = 0;
+			clock_t begin = clock();
+			for (int r = 0; r < runs; ++r) {
+				result += run(*k);
+			}
+			double elapsed_ms = double(clock() - begin) / CLOCKS_PER_SEC * 1000;
+			if (k == kernels.front()) reference = elapsed_ms;
+			cout << " " << k->name << " " << elapsed_ms << " ms (x" << reference / elapsed_ms << ", " << result << ")";
+		}
+		cout << endl;
+	};
+
+	measure("sum ints", [&](const ArrayKernels& k) { return k.sum_ints(ints.data(), size); });
+	measure("sum reals", [&](const ArrayKernels& k) { return k.sum_reals(reals.data(), size); });
+	measure("max ints", [&](const ArrayKernels& k) { return k.max_ints(ints.data(), size); });
+	measure("min ints", [&](const ArrayKernels& k) { return k.min_ints(ints.data(), size); });
+	measure("max reals", [&](const ArrayKernels& k) { return k.max_reals(reals.data(), size); });
+	measure("min reals", [&](const ArrayKernels& k) { return k.min_reals(reals.data(), size); });
+	measure("find int", [&](const ArrayKernels& k) { return k.find_int(ints.data(), size, ints.back()); });
+	measure("find real", [&](const ArrayKernels& k) { return k.find_real(reals.data(), size, reals.back()); });
+	vector<int> ints_result(size);
+	vector<double> reals_result(size);
+	measure("map ints", [&](const ArrayKernels& k) { k.map_ints(ArrayKernels::MUL, ints_result.data(), ints.data(), 3, size); return ints_result[size / 2]; });
+	measure("map reals", [&](const ArrayKernels& k) { k.map_reals(ArrayKernels::MUL, reals_result.data(), reals.data(), 1.5, size); return reals_result[size / 2]; });
+	measure("zip ints", [&](const ArrayKernels& k) { k.zip_ints(ArrayKernels::ADD, ints_result.data(), ints.data(), ints.data(), size); return ints_result[size / 2]; });
+	measure("zip reals", [&](const ArrayKernels& k) { k.zip_reals(ArrayKernels::DIV, reals_result.data(), reals.data(), reals.data(), size); return reals_result[size / 2]; });
+	measure("to reals", [&](const ArrayKernels& k) { k.to_reals(reals_result.data(), ints.data(), size); return reals_result[size / 2]; });
+	measure("fill ints", [&](const ArrayKernels& k) { k.fill_ints(ints.data(), size, 12); return ints[size / 2]; });
+	measure("fill reals", [&](const ArrayKernels& k) { k.fill_reals(reals.data(), size, 1.5); return reals[size / 2]; });
+}
@@ -5,6 +5,8 @@ class Benchmark {
 public:
 	Benchmark();
 	virtual ~Benchmark();
+
+	void array_kernels();
 };
 
 #endif
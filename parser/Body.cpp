@@ -2,6 +2,9 @@
 #include "../vm/value/LSNull.hpp"
 #include "../vm/value/LSNumber.hpp"
 #include "instruction/Return.hpp"
+#include "instruction/ExpressionInstruction.hpp"
+#include "instruction/VariableDeclaration.hpp"
+#include "value/FunctionCall.hpp"
 #include "../vm/VM.hpp"
 
 using namespace std;
@@ -32,6 +35,36 @@ void Body::analyse(SemanticAnalyser* analyser, const Type& req_type) {
 			type = instructions[i]->type;
 		}
 	}
+	// The value of a declaration ending the block is the value of the block
+	if (instructions.size() > 0) {
+		VariableDeclaration* vd = dynamic_cast<VariableDeclaration*>(instructions.back());
+		if (vd != nullptr and vd->variables.size() > 0) {
+			vd->vars.at(vd->variables.back()->content)->uses++;
+		}
+	}
+}
+
+void Body::fold() {
+	for (Instruction* instruction : instructions) {
+		instruction->fold();
+	}
+}
+
+/*
+ * An operation or a call producing a value that nobody will use
+ */
+static bool produces_temporary(Instruction* instruction, Type type) {
+	ExpressionInstruction* ei = dynamic_cast<ExpressionInstruction*>(instruction);
+	if (ei == nullptr) {
+		return false;
+	}
+	if (ei->value->type.nature != Nature::POINTER and type.nature != Nature::POINTER) {
+		return false;
+	}
+	if (Expression* ex = dynamic_cast<Expression*>(ei->value)) {
+		return ex->op != nullptr and ex->op->type != TokenType::EQUAL;
+	}
+	return dynamic_cast<FunctionCall*>(ei->value) != nullptr;
 }
 
 jit_value_t Body::compile_jit(Compiler& c, jit_function_t& F, Type type) const {
@@ -41,8 +74,18 @@ jit_value_t Body::compile_jit(Compiler& c, jit_function_t& F, Type type) const {
 		if (i == instructions.size() - 1) {
 			return instructions[i]->compile_jit(c, F, type);
 		} else {
-			instructions[i]->compile_jit(c, F, type);
+			jit_value_t res = instructions[i]->compile_jit(c, F, type);
+			if (produces_temporary(instructions[i], type)) {
+				VM::delete_temporary(F, res);
+			}
 		}
 	}
 	return JIT_CREATE_CONST_POINTER(F,LSNull::null_var);
 }
+
+/*
+ * Operations counted for an execution of the body, at once before it
+ */
+int Body::operations() const {
+	return instructions.size() > 0 ? instructions.size() : 1;
+}
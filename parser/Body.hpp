@@ -18,6 +18,8 @@ public:
 	void print(std::ostream& os);
 
 	void analyse(SemanticAnalyser* analyser, const Type& req_type);
+	void fold();
+	int operations() const;
 
 	jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const;
 };
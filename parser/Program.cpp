@@ -19,10 +19,6 @@ void Program::print(ostream& os) {
 	cout << endl;
 }
 
-extern map<string, jit_value_t> internals;
-extern map<string, jit_value_t> globals;
-extern map<string, Type> globals_types;
-
 LSArray* Program_create_array() {
 	return new LSArray();
 }
@@ -35,14 +31,35 @@ void Program_push_boolean(LSArray* array, int value) {
 void Program_push_integer(LSArray* array, int value) {
 	array->pushClone(LSNumber::get(value));
 }
-void Program_push_float(LSArray* array, float value) {
+void Program_push_float(LSArray* array, double value) {
 	array->pushClone(LSNumber::get(value));
 }
 void Program_push_function(LSArray* array, void* value) {
-	array->pushClone(new LSFunction(value));
+	array->pushNoClone(new LSFunction(value));
 }
 void Program_push_pointer(LSArray* array, LSValue* value) {
-	array->pushClone(value);
+	// Conditional declarations may have never been executed
+	array->pushClone(value == nullptr ? LSNull::null_var : value);
+}
+/*
+ * The values of the global variables are released right after : the array
+ * takes them over instead of copying them (the constants of the program,
+ * native, are still copied)
+ */
+void Program_push_global(LSArray* array, LSValue* value) {
+	if (value == nullptr or value->native) {
+		Program_push_pointer(array, value);
+	} else {
+		array->pushNoClone(value);
+	}
+}
+
+/*
+ * Compute the values known before the compilation, once the types and the
+ * assignments of the variables are known
+ */
+void Program::fold() {
+	body->fold();
 }
 
 void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool toplevel) {
@@ -63,7 +80,7 @@ void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool
 
 		//cout << value << endl;
 
-		internals.insert(pair<string, jit_value_t>(name, jit_val));
+		c.internals.insert(pair<string, jit_value_t>(name, jit_val));
 
 //		globals_infos.insert(pair<string, Info>(name, Info::pointer));
 //		jit_insn_store(F, jit_var, jit_val);
@@ -71,23 +88,51 @@ void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool
 		//cout << "var : " << jit_val << endl;
 	}
 
-	// User context variables
+	c.enter_function();
+
+	// User context variables, read from the array given as parameter so that
+	// the program can be executed again with other values. Only the ones
+	// used by the program are given : the others are left in the context.
+	context_vars.clear();
 	if (toplevel) {
-		for (auto var : context.vars) {
+		jit_value_t context_values = jit_value_get_param(F, 0);
+		int i = 0;
+		for (auto var : context.types()) {
 
 //			cout << "context var " << var.first << endl;
 
 			string name = var.first;
-			LSValue* value = var.second;
+			auto semantic_var = global_vars.find(name);
+			if (semantic_var == global_vars.end() or semantic_var->second->uses == 0) {
+				continue;
+			}
+			context_vars.push_back(name);
 
 			jit_value_t jit_var = jit_value_create(F, JIT_POINTER);
-			jit_value_t jit_val = JIT_CREATE_CONST_POINTER(F, value);
+			jit_value_t jit_val = jit_insn_load_relative(F, context_values, i++ * sizeof(LSValue*), JIT_POINTER);
 			jit_insn_store(F, jit_var, jit_val);
+			VM::inc_refs(F, jit_var);
+			c.add_function_var(jit_var);
 
 //			cout << jit_var << endl;
 
-			globals.insert(pair<string, jit_value_t>(name, jit_var));
-			globals_types.insert(pair<string, Type>(name, Type(value->getRawType(), Nature::POINTER)));
+			c.globals.insert(pair<string, jit_value_t>(name, jit_var));
+			c.globals_types.insert(pair<string, Type>(name, Type(var.second, Nature::POINTER)));
+		}
+	}
+
+	// Global pointer variables are created here, so that they can be released
+	// at the end even if their declaration is never executed
+	for (auto var : global_vars) {
+		if (var.second->scope == VarScope::GLOBAL and var.second->value != nullptr
+			and var.second->type.nature == Nature::POINTER
+			and c.globals.find(var.first) == c.globals.end()) {
+
+			jit_value_t jit_var = jit_value_create(F, JIT_POINTER);
+			jit_insn_store(F, jit_var, jit_value_create_nint_constant(F, JIT_POINTER, 0));
+			c.globals.insert(pair<string, jit_value_t>(var.first, jit_var));
+			c.globals_types.insert(pair<string, Type>(var.first, var.second->type));
+			c.add_function_var(jit_var);
 		}
 	}
 
@@ -114,10 +159,10 @@ void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool
 
 //		cout << "GLOBALS : " << globals.size() << endl;
 
-		for (auto g : globals) {
+		for (auto g : c.globals) {
 
 			string name = g.first;
-			Type type = globals_types[name];
+			Type type = c.globals_types[name];
 
 //			cout << "save in context : " << name << ", type: " << type << endl;
 //			cout << "jit_val: " << g.second << endl;
@@ -127,7 +172,7 @@ void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool
 			if (type.nature == Nature::POINTER) {
 
 //				cout << "save pointer" << endl;
-				jit_insn_call_native(F, "push", (void*) &Program_push_pointer, push_sig_pointer, var_args, 2, 0);
+				jit_insn_call_native(F, "push", (void*) &Program_push_global, push_sig_pointer, var_args, 2, 0);
 
 			} else {
 //				cout << "save value" << endl;
@@ -149,11 +194,21 @@ void Program::compile_jit(Compiler& c, jit_function_t& F, Context& context, bool
 					jit_insn_call_native(F, "push", (void*) &Program_push_float, sig_push_float, var_args, 2, JIT_CALL_NOTHROW);
 				} else if (type.raw_type == RawType::FUNCTION) {
 					jit_insn_call_native(F, "push", (void*) &Program_push_function, push_sig_pointer, var_args, 2, JIT_CALL_NOTHROW);
+				} else {
+					// Not kept in the context, but the next globals keep their positions
+					jit_type_t push_args_types[2] = {JIT_POINTER, JIT_INTEGER};
+					jit_type_t push_sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, push_args_types, 2, 0);
+					jit_value_t null_args[2] = {array, JIT_CREATE_CONST(F, JIT_INTEGER, 0)};
+					jit_insn_call_native(F, "push", (void*) &Program_push_null, push_sig, null_args, 2, JIT_CALL_NOTHROW);
 				}
 			}
 		}
+		VM::delete_temporary(F, res);
+		c.delete_function_vars(F, nullptr);
 		jit_insn_return(F, array);
 	} else {
+		c.delete_function_vars(F, res);
 		jit_insn_return(F, res);
 	}
+	c.leave_function();
 }
@@ -12,6 +12,8 @@ public:
 	std::vector<Function*> functions;
 	std::map<std::string, SemanticVar*> global_vars;
 	std::map<std::string, LSValue*> system_vars;
+	// Context variables given to the compiled program, in their order
+	std::vector<std::string> context_vars;
 	Body* body;
 
 	Program();
@@ -19,6 +21,8 @@ public:
 
 	void print(std::ostream& os);
 
+	void fold();
+
 	void compile_jit(Compiler&, jit_function_t&, Context&, bool);
 };
 
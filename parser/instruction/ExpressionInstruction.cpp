@@ -19,6 +19,10 @@ void ExpressionInstruction::analyse(SemanticAnalyser* analyser, const Type& req_
 	type = value->type;
 }
 
+void ExpressionInstruction::fold() {
+	value->fold();
+}
+
 jit_value_t ExpressionInstruction::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
 	return value->compile_jit(c, F, req_type);
 }
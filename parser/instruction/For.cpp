@@ -2,6 +2,10 @@
 #include "For.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../value/Number.hpp"
+#include "../value/VariableValue.hpp"
+#include "../value/PrefixExpression.hpp"
+#include "../value/PostfixExpression.hpp"
+#include "LoopMotion.hpp"
 
 using namespace std;
 
@@ -60,24 +64,94 @@ void For::analyse(SemanticAnalyser* analyser, const Type& req_type) {
 			value = variablesValues[i];
 		}
 		if (declare_variables[i]) {
-			SemanticVar* v = analyser->add_var(var, info, value);
-			vars.insert(pair<string, SemanticVar*>(var->content, v));
+			vars[var->content] = analyser->add_var(var, info, value);
 		} else {
-			SemanticVar* v = analyser->get_var(var);
-			vars.insert(pair<string, SemanticVar*>(var->content, v));
+			vars[var->content] = analyser->get_var(var);
 		}
 	}
+
+	loop_depth = ++analyser->loop_depth;
+
 	if (condition != nullptr) {
 		condition->analyse(analyser);
 	}
+
+	vector<int> assignments;
+	for (Token* var : variables) {
+		assignments.push_back(vars.at(var->content)->assignments);
+	}
 	for (auto it : iterations) {
 		it->analyse(analyser);
 	}
+	induction = -1;
+	for (unsigned i = 0; i < variables.size(); ++i) {
+		if (induction_variable(i, assignments[i])) {
+			induction = i;
+		}
+	}
+
 	body->analyse(analyser, req_type);
+
+	// The body must not change the induction variable
+	if (induction != -1 and vars.at(variables[induction]->content)->assignments != assignments[induction] + 1) {
+		induction = -1;
+	}
+
+	analyser->loop_depth--;
+}
+
+/*
+ * An integer variable declared by the loop, changed only by the iteration,
+ * of a constant step : k++, k--, ++k, --k, k += 2, k -= 2
+ */
+bool For::induction_variable(unsigned i, int assignments) {
+
+	SemanticVar* var = vars.at(variables[i]->content);
+	if (not declare_variables[i] or variablesValues.at(i) == nullptr or iterations.size() != 1
+		or var->type.nature != Nature::VALUE or var->type.raw_type != RawType::INTEGER
+		or var->assignments != assignments + 1) {
+		return false;
+	}
+
+	VariableValue* vv = nullptr;
+	int step = 0;
+	if (PostfixExpression* pe = dynamic_cast<PostfixExpression*>(iterations[0])) {
+		vv = dynamic_cast<VariableValue*>(pe->expression);
+		if (pe->operatorr->type == TokenType::PLUS_PLUS) step = 1;
+		if (pe->operatorr->type == TokenType::MINUS_MINUS) step = -1;
+	} else if (PrefixExpression* pe = dynamic_cast<PrefixExpression*>(iterations[0])) {
+		vv = dynamic_cast<VariableValue*>(pe->expression);
+		if (pe->operatorr->type == TokenType::PLUS_PLUS) step = 1;
+		if (pe->operatorr->type == TokenType::MINUS_MINUS) step = -1;
+	} else if (Expression* ex = dynamic_cast<Expression*>(iterations[0])) {
+		Number* n = ex->v2 != nullptr ? dynamic_cast<Number*>(ex->v2) : nullptr;
+		if (ex->op != nullptr and n != nullptr and n->type.raw_type == RawType::INTEGER) {
+			vv = dynamic_cast<VariableValue*>(ex->v1);
+			if (ex->op_type == TokenType::PLUS_EQUAL) step = n->value;
+			if (ex->op_type == TokenType::MINUS_EQUAL) step = -n->value;
+		}
+	}
+	if (vv == nullptr or vv->var != var or step == 0) {
+		return false;
+	}
+	induction_step = step;
+	return true;
 }
 
-extern map<string, jit_value_t> globals;
-extern map<string, jit_value_t> locals;
+void For::fold() {
+	for (Value* value : variablesValues) {
+		if (value != nullptr) {
+			value->fold();
+		}
+	}
+	if (condition != nullptr) {
+		condition->fold();
+	}
+	for (Value* iteration : iterations) {
+		iteration->fold();
+	}
+	body->fold();
+}
 
 int for_is_true(LSValue* v) {
 	return v->isTrue();
@@ -89,31 +163,48 @@ jit_value_t For::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 		return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
 	}
 
+	jit_value_t induction_value = nullptr;
+
 	// Initialization
 	for (unsigned i = 0; i < variables.size(); ++i) {
 
 		SemanticVar* v = vars.at(variables.at(i)->content);
 
+		map<string, jit_value_t>& scope_vars = v->scope == VarScope::GLOBAL ? c.globals : c.locals;
+
 		jit_value_t var;
 		if (declare_variables[i]) {
-			var = jit_value_create(F, JIT_INTEGER);
-			globals.insert(pair<string, jit_value_t>(variables[i]->content, var));
-		} else {
-			if (v->scope == VarScope::GLOBAL) {
-				var = globals.at(variables[i]->content);
+			// Pointer variables are already created by the function, which owns their values
+			auto fv = scope_vars.find(variables[i]->content);
+			if (fv != scope_vars.end() and c.is_function_var(fv->second)) {
+				var = fv->second;
 			} else {
-				var = locals.at(variables[i]->content);
+				var = jit_value_create(F, JIT_INTEGER);
+				c.globals.insert(pair<string, jit_value_t>(variables[i]->content, var));
 			}
+		} else {
+			var = scope_vars.at(variables[i]->content);
 		}
 		if (variablesValues.at(i) != nullptr) {
 			jit_value_t val = variablesValues.at(i)->compile_jit(c, F, Type::NEUTRAL);
-			jit_insn_store(F, var, val);
+			if (c.is_function_var(var)) {
+				if (variablesValues.at(i)->type.nature != Nature::POINTER) {
+					val = VM::value_to_pointer(F, val, variablesValues.at(i)->type);
+				}
+				VM::store_value(F, var, val);
+			} else {
+				jit_insn_store(F, var, val);
+			}
 		} else {
 			jit_value_t val = JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
 			jit_insn_store(F, var, val);
 		}
+		if ((int) i == induction) {
+			induction_value = var;
+		}
 	}
 
+	jit_label_t label_preheader = jit_label_undefined;
 	jit_label_t label_cond = jit_label_undefined;
 	jit_label_t label_it = jit_label_undefined;
 	jit_label_t label_end = jit_label_undefined;
@@ -121,10 +212,16 @@ jit_value_t For::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 	jit_type_t args_types[1] = {JIT_POINTER};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_types, 1, 0);
 
+	SemanticVar* induction_var = induction != -1 ? vars.at(variables[induction]->content) : nullptr;
+	LoopMotion motion(c, loop_depth, induction_var, induction_value, induction_step);
+	c.loop_motions.push_back(&motion);
 	c.enter_loop(&label_end, &label_it);
 
+	jit_insn_branch(F, &label_preheader);
+
 	// condition label:
 	jit_insn_label(F, &label_cond);
+	c.vm->inc_ops(F, body->operations());
 
 	// condition
 	jit_value_t cond = condition->compile_jit(c, F, Type::NEUTRAL);
@@ -147,14 +244,21 @@ jit_value_t For::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 	for (Value* it : iterations) {
 		it->compile_jit(c, F, Type::NEUTRAL);
 	}
+	motion.compile_updates(F);
 
 	// jump to condition
 	jit_insn_branch(F, &label_cond);
 
+	// preheader, run once before the first condition
+	jit_insn_label(F, &label_preheader);
+	motion.compile_preheader(c, F);
+	jit_insn_branch(F, &label_cond);
+
 	// end label:
 	jit_insn_label(F, &label_end);
 
 	c.leave_loop();
+	c.loop_motions.pop_back();
 
 	return JIT_CREATE_CONST_POINTER(F,LSNull::null_var);
 }
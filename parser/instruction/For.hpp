@@ -19,6 +19,10 @@ public:
 	std::vector<Value*> iterations;
 	Body* body;
 	std::map<std::string, SemanticVar*> vars;
+	int loop_depth;
+	// Variable only changed by the iteration, of `induction_step` each time
+	int induction = -1;
+	int induction_step;
 
 	For();
 	virtual ~For();
@@ -26,6 +30,8 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type& req_type) override;
+	bool induction_variable(unsigned i, int assignments);
+	virtual void fold() override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 };
@@ -41,39 +41,70 @@ void Foreach::analyse(SemanticAnalyser* analyser, const Type& req_type) {
 	array->analyse(analyser, Type::NEUTRAL);
 
 	var_type = Type::POINTER;
-	/*
+	Type key_type = Type::POINTER;
+
+	// The values of an unboxed array literal are iterated unboxed
 	if (Array* a = dynamic_cast<Array*>(array)) {
-		if (a->only_values) {
-			var_type = Type::VALUE;
+		RawType unboxed = a->unboxed_type();
+		if (unboxed != RawType::UNKNOWN) {
+			var_type = unboxed == RawType::FLOAT ? Type::FLOAT : Type::INTEGER;
+			key_type = Type::INTEGER;
 		}
 	}
-	*/
+
+	// The variables change at each iteration
+	analyser->loop_depth++;
 
 	if (key != nullptr) {
-		key_var = analyser->add_var(key, Type::POINTER, nullptr);
+		key_var = analyser->add_var(key, key_type, nullptr);
 	}
 
 	value_var = analyser->add_var(value, var_type, nullptr);
 
 	body->analyse(analyser, req_type);
+
+	analyser->loop_depth--;
 }
 
-extern map<string, jit_value_t> globals;
+void Foreach::fold() {
+	array->fold();
+	body->fold();
+}
 
-LSArrayIterator get_array_begin(LSArray* a) {
-	return a->begin();
+ForeachIterator* get_array_begin(LSArray* a) {
+	if (a->unboxed != RawType::UNKNOWN) {
+		return new ForeachIterator(LSArrayIterator(a, 0, a->entries.end()));
+	}
+	return new ForeachIterator(a->begin());
 }
 
-LSArrayIterator get_array_end(LSArray* a) {
-	return a->end();
+int is_array_end(ForeachIterator* it) {
+	return it->it.at_end();
 }
 
-LSValue* get_array_elem(LSArrayIterator it) {
-	return it->second;
+LSValue* get_array_elem(ForeachIterator* it) {
+	const LSArray* a = it->it.array;
+	LSValue::delete_ref(it->number);
+	it->number = nullptr;
+	// The array can be boxed by the body of the loop
+	if (a->unboxed == RawType::UNKNOWN) {
+		return it->it.value();
+	}
+	size_t i = it->it.position;
+	it->number = LSNumber::get(a->unboxed == RawType::INTEGER ? a->ints[i] : a->reals[i]);
+	LSValue::inc_refs(it->number);
+	return it->number;
 }
 
-LSValue* get_array_key(LSArrayIterator it) {
-	return it->first;
+LSValue* get_array_key(ForeachIterator* it) {
+	LSValue* key = it->it.key();
+	if (key != nullptr) {
+		return key;
+	}
+	LSValue::delete_ref(it->list_key);
+	it->list_key = LSNumber::get(it->it.position);
+	LSValue::inc_refs(it->list_key);
+	return it->list_key;
 }
 
 int get_array_elem_int(LSArray* a, int i) {
@@ -81,20 +112,38 @@ int get_array_elem_int(LSArray* a, int i) {
 	return (int) ((LSNumber*) v)->value;
 }
 
-LSArrayIterator iterator_inc(LSArrayIterator it) {
-	return ++it;
+void iterator_inc(ForeachIterator* it) {
+	++it->it;
+}
+
+void iterator_delete(ForeachIterator* it) {
+	delete it;
+}
+
+void* get_array_data(LSArray* a) {
+	return a->unboxed == RawType::FLOAT ? (void*) a->reals.data() : (void*) a->ints.data();
+}
+
+int get_array_size(LSArray* a) {
+	return a->size();
 }
 
 jit_value_t Foreach::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 
+	if (var_type.nature == Nature::VALUE) {
+		return compile_jit_unboxed(c, F);
+	}
+
 	// Labels
 	jit_label_t label_cond = jit_label_undefined;
+	jit_label_t label_inc = jit_label_undefined;
 	jit_label_t label_end = jit_label_undefined;
 
-	c.enter_loop(&label_end, &label_cond);
+	c.enter_loop(&label_end, &label_inc);
 
-	// Array
-	jit_value_t a = array->compile_jit(c, F, Type::NEUTRAL);
+	// Array, held by the loop : the body can reassign or clear its variable
+	jit_value_t a = jit_insn_load(F, array->compile_jit(c, F, Type::NEUTRAL));
+	VM::inc_refs(F, a);
 
 	// Variable it = begin()
 	jit_value_t it = jit_value_create(F, JIT_POINTER);
@@ -102,25 +151,28 @@ jit_value_t Foreach::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 	jit_type_t sig_begin = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types_begin, 1, 0);
 	jit_insn_store(F, it, jit_insn_call_native(F, "begin", (void*) get_array_begin, sig_begin, &a, 1, JIT_CALL_NOTHROW));
 
+	// Current element, held until the next one : the body can remove it from the array
+	jit_value_t elem = jit_value_create(F, JIT_POINTER);
+	jit_insn_store(F, elem, JIT_CREATE_CONST_POINTER(F, LSNull::null_var));
+
 	// cond label:
 	jit_insn_label(F, &label_cond);
+	c.vm->inc_ops(F, body->operations());
 
-	// Get array end()
+	// if (it is at the end) jump to end
 	jit_type_t args_types[1] = {JIT_POINTER};
-	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
-	jit_value_t end = jit_insn_call_native(F, "end", (void*) get_array_end, sig, &a, 1, JIT_CALL_NOTHROW);
-
-	// if (i == size) jump to end
-	jit_value_t cmp = jit_insn_eq(F, it, end);
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_types, 1, 0);
+	jit_value_t cmp = jit_insn_call_native(F, "end", (void*) is_array_end, sig, &it, 1, JIT_CALL_NOTHROW);
 	jit_insn_branch_if(F, cmp, &label_end);
 
 	// Get array element (each value of array)
 	jit_value_t value_val;
 	if (var_type.nature == Nature::POINTER) {
-//		cout << "compile pointer" << endl;
 		jit_type_t args_types[1] = {JIT_POINTER};
 		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
 		value_val = jit_insn_call_native(F, "get", (void*) get_array_elem, sig, &it, 1, JIT_CALL_NOTHROW);
+		jit_insn_store(F, elem, value_val);
+		VM::inc_refs(F, elem);
 	} else {
 		jit_type_t args_types[2] = {JIT_POINTER, JIT_INTEGER};
 		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_types, 2, 0);
@@ -129,27 +181,31 @@ jit_value_t Foreach::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 
 	jit_value_t value_var = jit_value_create(F, JIT_POINTER);
 	jit_insn_store(F, value_var, value_val);
-	globals.insert(pair<string, jit_value_t>(value->content, value_var));
+	c.globals[value->content] = value_var;
 
 	// Key
+	jit_value_t key_jit = nullptr;
 	if (key != nullptr) {
 
 		jit_type_t args_types[1] = {JIT_POINTER};
 		jit_type_t sig2 = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
 		jit_value_t key_val = jit_insn_call_native(F, "get", (void*) get_array_key, sig2, &it, 1, JIT_CALL_NOTHROW);
 
-		jit_value_t key_var = jit_value_create(F, JIT_POINTER);
-		jit_insn_store(F, key_var, key_val);
-		globals.insert(pair<string, jit_value_t>(key->content, key_var));
+		key_jit = jit_value_create(F, JIT_POINTER);
+		jit_insn_store(F, key_jit, key_val);
+		c.globals[key->content] = key_jit;
 	}
 
 	// body
 	body->compile_jit(c, F, Type::NEUTRAL);
 
-	// it++
+	// inc label: release the element, it++
+	jit_insn_label(F, &label_inc);
+	VM::delete_ref(F, elem);
+	jit_insn_store(F, elem, JIT_CREATE_CONST_POINTER(F, LSNull::null_var));
 	jit_type_t args_types_3[1] = {JIT_POINTER};
-	jit_type_t sig3 = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types_3, 1, 0);
-	jit_insn_store(F, it, jit_insn_call_native(F, "inc", (void*) iterator_inc, sig3, &it, 1, JIT_CALL_NOTHROW));
+	jit_type_t sig3 = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args_types_3, 1, 0);
+	jit_insn_call_native(F, "inc", (void*) iterator_inc, sig3, &it, 1, JIT_CALL_NOTHROW);
 
 	// jump to cond
 	jit_insn_branch(F, &label_cond);
@@ -157,6 +213,87 @@ jit_value_t Foreach::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 	// end label:
 	jit_insn_label(F, &label_end);
 
+	// The variables would point to released values after the loop
+	VM::delete_ref(F, elem);
+	jit_insn_call_native(F, "delete", (void*) iterator_delete, sig3, &it, 1, JIT_CALL_NOTHROW);
+	if (var_type.nature == Nature::POINTER) {
+		jit_insn_store(F, value_var, JIT_CREATE_CONST_POINTER(F, LSNull::null_var));
+	}
+	if (key_jit != nullptr) {
+		jit_insn_store(F, key_jit, JIT_CREATE_CONST_POINTER(F, LSNull::null_var));
+	}
+
+	// Release the array, and delete it if it was a temporary value
+	VM::delete_ref(F, a);
+
+	c.leave_loop();
+
+	return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
+}
+
+/*
+ * The array literal can't be reached from the body of the loop,
+ * so its buffer of raw values is read directly
+ */
+jit_value_t Foreach::compile_jit_unboxed(Compiler& c, jit_function_t& F) const {
+
+	// Labels
+	jit_label_t label_cond = jit_label_undefined;
+	jit_label_t label_inc = jit_label_undefined;
+	jit_label_t label_end = jit_label_undefined;
+
+	c.enter_loop(&label_end, &label_inc);
+
+	// Array
+	jit_value_t a = array->compile_jit(c, F, Type::POINTER);
+
+	jit_type_t args_types[1] = {JIT_POINTER};
+	jit_type_t sig_data = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
+	jit_value_t data = jit_insn_call_native(F, "data", (void*) get_array_data, sig_data, &a, 1, JIT_CALL_NOTHROW);
+	jit_type_t sig_size = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_types, 1, 0);
+	jit_value_t size = jit_insn_call_native(F, "size", (void*) get_array_size, sig_size, &a, 1, JIT_CALL_NOTHROW);
+
+	// Variable i = 0
+	jit_value_t i = jit_value_create(F, JIT_INTEGER);
+	jit_insn_store(F, i, JIT_CREATE_CONST(F, JIT_INTEGER, 0));
+
+	jit_type_t elem_type = var_type.raw_type == RawType::FLOAT ? JIT_FLOAT : JIT_INTEGER;
+	jit_value_t value_var = jit_value_create(F, elem_type);
+	c.globals[value->content] = value_var;
+
+	jit_value_t key_jit = nullptr;
+	if (key != nullptr) {
+		key_jit = jit_value_create(F, JIT_INTEGER);
+		c.globals[key->content] = key_jit;
+	}
+
+	// cond label:
+	jit_insn_label(F, &label_cond);
+	c.vm->inc_ops(F, body->operations());
+
+	// if (i >= size) jump to end
+	jit_insn_branch_if_not(F, jit_insn_lt(F, i, size), &label_end);
+
+	jit_insn_store(F, value_var, jit_insn_load_elem(F, data, i, elem_type));
+	if (key_jit != nullptr) {
+		jit_insn_store(F, key_jit, i);
+	}
+
+	// body
+	body->compile_jit(c, F, Type::NEUTRAL);
+
+	// i++
+	jit_insn_label(F, &label_inc);
+	jit_insn_store(F, i, jit_insn_add(F, i, JIT_CREATE_CONST(F, JIT_INTEGER, 1)));
+
+	// jump to cond
+	jit_insn_branch(F, &label_cond);
+
+	// end label:
+	jit_insn_label(F, &label_end);
+
+	VM::delete_temporary(F, a);
+
 	c.leave_loop();
 
 	return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
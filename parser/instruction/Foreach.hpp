@@ -7,6 +7,7 @@
 #include "../Body.hpp"
 #include "../value/Expression.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
+#include "../../vm/value/LSArray.hpp"
 
 class Foreach : public Instruction {
 public:
@@ -25,8 +26,34 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type& req_type) override;
+	virtual void fold() override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
+	jit_value_t compile_jit_unboxed(Compiler&, jit_function_t&) const;
 };
 
+/*
+ * Position of a loop in an array. The keys of a list don't exist in the
+ * array, the current one is created and held by the loop, as the current
+ * value of an unboxed array : it's iterated without being boxed.
+ */
+class ForeachIterator {
+public:
+	LSArrayIterator it;
+	LSValue* list_key;
+	LSValue* number;
+	ForeachIterator(LSArrayIterator it) : it(it), list_key(nullptr), number(nullptr) {}
+	~ForeachIterator() {
+		LSValue::delete_ref(list_key);
+		LSValue::delete_ref(number);
+	}
+};
+
+ForeachIterator* get_array_begin(LSArray* a);
+int is_array_end(ForeachIterator* it);
+LSValue* get_array_elem(ForeachIterator* it);
+LSValue* get_array_key(ForeachIterator* it);
+void iterator_inc(ForeachIterator* it);
+void iterator_delete(ForeachIterator* it);
+
 #endif
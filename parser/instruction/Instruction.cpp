@@ -1,3 +1,5 @@
 #include "Instruction.hpp"
 
 Instruction::~Instruction() {}
+
+void Instruction::fold() {}
@@ -15,6 +15,7 @@ public:
 	virtual void print(std::ostream&) const = 0;
 
 	virtual void analyse(SemanticAnalyser* analyser, const Type& type) = 0;
+	virtual void fold();
 
  	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const = 0;
 };
@@ -0,0 +1,235 @@
+#include "LoopMotion.hpp"
+#include "../../vm/VM.hpp"
+#include "../semantic/SemanticAnalyser.hpp"
+#include "../value/Expression.hpp"
+#include "../value/PrefixExpression.hpp"
+#include "../value/VariableValue.hpp"
+#include "../value/Number.hpp"
+
+using namespace std;
+
+LoopMotion::LoopMotion(Compiler& c, int depth, SemanticVar* induction, jit_value_t induction_value, int step)
+	: depth(depth), induction(induction), induction_value(induction_value), step(step), active(true),
+	  globals(c.globals), locals(c.locals), inlined_arguments(c.inlined_arguments) {}
+
+/*
+ * Numbers and booleans, stored in jit values of a type known before their compilation
+ */
+static bool is_number(const Value* value) {
+	return value->type.nature == Nature::VALUE and (value->type.raw_type == RawType::INTEGER
+		or value->type.raw_type == RawType::FLOAT or value->type.raw_type == RawType::BOOLEAN);
+}
+
+static bool is_integer(const Value* value) {
+	return value->type.nature == Nature::VALUE and value->type.raw_type == RawType::INTEGER;
+}
+
+static jit_value_t create_uint(jit_function_t& F, uint32_t value) {
+	return JIT_CREATE_CONST(F, JIT_INTEGER, (int32_t) value);
+}
+
+/*
+ * Compiles the value as a read of the variable it's moved into, when it's
+ * invariant or reduced in the innermost loop being compiled : nullptr otherwise
+ */
+jit_value_t LoopMotion::compile_moved(Compiler& c, jit_function_t& F, const Value* value, Type req_type) {
+
+	if (c.loop_motions.empty() or req_type.nature == Nature::POINTER or not is_number(value)) {
+		return nullptr;
+	}
+	LoopMotion* motion = c.loop_motions.back();
+	if (not motion->active) {
+		return nullptr;
+	}
+	for (const Reduction& reduction : motion->reductions) {
+		if (reduction.value == value) return reduction.q;
+	}
+	for (const auto& invariant : motion->invariants) {
+		if (invariant.first == value) return invariant.second;
+	}
+
+	if (motion->induction != nullptr) {
+		Reduction reduction;
+		int degree;
+		bool multiplied;
+		if (motion->polynomial(value, reduction.a, degree, multiplied) and degree > 0
+			and (degree == 2 or multiplied)) {
+			reduction.value = value;
+			reduction.q = jit_value_create(F, JIT_INTEGER);
+			reduction.dq = jit_value_create(F, JIT_INTEGER);
+			motion->reductions.push_back(reduction);
+			return reduction.q;
+		}
+	}
+	if (motion->is_invariant(value)) {
+		jit_value_t var = jit_value_create(F, value->type.raw_type == RawType::FLOAT ? JIT_FLOAT : JIT_INTEGER);
+		motion->invariants.push_back({value, var});
+		return var;
+	}
+	return nullptr;
+}
+
+bool LoopMotion::is_invariant(const Value* value) const {
+
+	if (not is_number(value)) {
+		return false;
+	}
+	if (value->literal() != nullptr) {
+		return true;
+	}
+	if (const VariableValue* vv = dynamic_cast<const VariableValue*>(value)) {
+		return vv->var->scope != VarScope::INTERNAL and vv->var->assignments == 0
+			and vv->var->loop_depth < depth;
+	}
+	if (const Expression* ex = dynamic_cast<const Expression*>(value)) {
+		if (ex->op == nullptr) {
+			return is_invariant(ex->v1);
+		}
+		switch (ex->op_type) {
+			case TokenType::PLUS:
+			case TokenType::MINUS:
+			case TokenType::TIMES:
+			case TokenType::DOUBLE_EQUAL:
+			case TokenType::DIFFERENT:
+			case TokenType::LOWER:
+			case TokenType::LOWER_EQUALS:
+			case TokenType::GREATER:
+			case TokenType::GREATER_EQUALS:
+				break;
+			case TokenType::MODULO: {
+				// Moved before the condition : it must not divide by zero
+				const Number* divisor = dynamic_cast<const Number*>(ex->v2->literal());
+				if (divisor == nullptr or divisor->value == 0) {
+					return false;
+				}
+				break;
+			}
+			default:
+				return false;
+		}
+		return is_invariant(ex->v1) and is_invariant(ex->v2);
+	}
+	if (const PrefixExpression* pe = dynamic_cast<const PrefixExpression*>(value)) {
+		return (pe->operatorr->type == TokenType::MINUS or pe->operatorr->type == TokenType::NOT)
+			and is_invariant(pe->expression);
+	}
+	return false;
+}
+
+/*
+ * Coefficients a[0] + a[1] * k + a[2] * k * k of an integer value, polynomial
+ * of the induction variable k with literal coefficients
+ */
+bool LoopMotion::polynomial(const Value* value, uint32_t a[3], int& degree, bool& multiplied) const {
+
+	if (not is_integer(value)) {
+		return false;
+	}
+	a[0] = a[1] = a[2] = 0;
+	degree = 0;
+	multiplied = false;
+
+	if (const Number* n = dynamic_cast<const Number*>(value->literal())) {
+		a[0] = (uint32_t) (int32_t) n->value;
+		return true;
+	}
+	if (const VariableValue* vv = dynamic_cast<const VariableValue*>(value)) {
+		if (vv->var != induction) {
+			return false;
+		}
+		a[1] = 1;
+		degree = 1;
+		return true;
+	}
+	if (const PrefixExpression* pe = dynamic_cast<const PrefixExpression*>(value)) {
+		if (pe->operatorr->type != TokenType::MINUS or not polynomial(pe->expression, a, degree, multiplied)) {
+			return false;
+		}
+		for (int i = 0; i < 3; ++i) a[i] = -a[i];
+		return true;
+	}
+	const Expression* ex = dynamic_cast<const Expression*>(value);
+	if (ex == nullptr) {
+		return false;
+	}
+	if (ex->op == nullptr) {
+		return polynomial(ex->v1, a, degree, multiplied);
+	}
+	TokenType op = ex->op_type;
+	if (op != TokenType::PLUS and op != TokenType::MINUS and op != TokenType::TIMES) {
+		return false;
+	}
+	uint32_t x[3], y[3];
+	int dx, dy;
+	bool mx, my;
+	if (not polynomial(ex->v1, x, dx, mx) or not polynomial(ex->v2, y, dy, my)) {
+		return false;
+	}
+	multiplied = mx or my;
+	if (op == TokenType::TIMES) {
+		if (dx + dy > 2) {
+			return false;
+		}
+		a[0] = x[0] * y[0];
+		a[1] = x[0] * y[1] + x[1] * y[0];
+		a[2] = x[0] * y[2] + x[1] * y[1] + x[2] * y[0];
+		degree = dx + dy;
+		multiplied = true;
+	} else {
+		for (int i = 0; i < 3; ++i) {
+			a[i] = op == TokenType::PLUS ? x[i] + y[i] : x[i] - y[i];
+		}
+		degree = max(dx, dy);
+	}
+	return true;
+}
+
+/*
+ * At the end of an iteration, k increased of s :
+ * P(k + s) = P(k) + dP(k) with dP(k) = 2 a2 s k + a1 s + a2 s², and dP(k + s) = dP(k) + 2 a2 s²
+ */
+void LoopMotion::compile_updates(jit_function_t& F) const {
+
+	uint32_t s = step;
+	for (const Reduction& r : reductions) {
+		if (r.a[2] == 0) {
+			jit_insn_store(F, r.q, jit_insn_add(F, r.q, create_uint(F, r.a[1] * s)));
+		} else {
+			jit_insn_store(F, r.q, jit_insn_add(F, r.q, r.dq));
+			jit_insn_store(F, r.dq, jit_insn_add(F, r.dq, create_uint(F, 2 * r.a[2] * s * s)));
+		}
+	}
+}
+
+void LoopMotion::compile_preheader(Compiler& c, jit_function_t& F) {
+
+	// The variables as they were before the loop
+	map<string, jit_value_t> loop_globals = c.globals;
+	map<string, jit_value_t> loop_locals = c.locals;
+	vector<jit_value_t>* loop_inlined_arguments = c.inlined_arguments;
+	c.globals = globals;
+	c.locals = locals;
+	c.inlined_arguments = inlined_arguments;
+	active = false;
+
+	for (const auto& invariant : invariants) {
+		jit_value_t v = invariant.first->compile_jit(c, F, Type::NEUTRAL);
+		jit_insn_store(F, invariant.second, v);
+	}
+
+	uint32_t s = step;
+	for (const Reduction& r : reductions) {
+		jit_value_t k = induction_value;
+		// q = a0 + k (a1 + a2 k)
+		jit_value_t q = jit_insn_mul(F, k, jit_insn_add(F, create_uint(F, r.a[1]), jit_insn_mul(F, create_uint(F, r.a[2]), k)));
+		jit_insn_store(F, r.q, jit_insn_add(F, create_uint(F, r.a[0]), q));
+		if (r.a[2] != 0) {
+			jit_value_t dq = jit_insn_mul(F, create_uint(F, 2 * r.a[2] * s), k);
+			jit_insn_store(F, r.dq, jit_insn_add(F, dq, create_uint(F, r.a[1] * s + r.a[2] * s * s)));
+		}
+	}
+
+	c.globals = loop_globals;
+	c.locals = loop_locals;
+	c.inlined_arguments = loop_inlined_arguments;
+}
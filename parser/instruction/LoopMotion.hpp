@@ -0,0 +1,60 @@
+#ifndef LOOPMOTION_HPP
+#define LOOPMOTION_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <jit/jit.h>
+#include "../../Compiler.hpp"
+#include "../../vm/Type.hpp"
+class Value;
+class SemanticVar;
+
+/*
+ * Code moved out of the body of a loop while it's compiled :
+ * - the invariant expressions (only made of literals and of variables never
+ *   assigned, declared outside the loop) are computed once, before the first
+ *   iteration, and read from a variable in the loop ;
+ * - the polynomials of the induction variable of a for loop (36 * k * k - 12 * k)
+ *   are kept in a variable updated with additions at each iteration.
+ * The preheader computing these variables is compiled after the loop (the
+ * moved expressions are only known then), and run before the condition.
+ */
+class LoopMotion {
+public:
+
+	struct Reduction {
+		const Value* value;
+		jit_value_t q;
+		jit_value_t dq;
+		// Coefficients of the polynomial, in the wrapping 32 bits integers arithmetic
+		uint32_t a[3];
+	};
+
+	int depth;
+	SemanticVar* induction;
+	jit_value_t induction_value;
+	int step;
+	bool active;
+
+	std::map<std::string, jit_value_t> globals;
+	std::map<std::string, jit_value_t> locals;
+	std::vector<jit_value_t>* inlined_arguments;
+
+	std::vector<std::pair<const Value*, jit_value_t>> invariants;
+	std::vector<Reduction> reductions;
+
+	LoopMotion(Compiler&, int depth, SemanticVar* induction = nullptr, jit_value_t induction_value = nullptr, int step = 0);
+
+	static jit_value_t compile_moved(Compiler&, jit_function_t&, const Value*, Type req_type);
+
+	void compile_updates(jit_function_t&) const;
+	void compile_preheader(Compiler&, jit_function_t&);
+
+private:
+	bool is_invariant(const Value*) const;
+	bool polynomial(const Value*, uint32_t a[3], int& degree, bool& multiplied) const;
+};
+
+#endif
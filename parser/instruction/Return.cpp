@@ -2,6 +2,7 @@
 #include "../../vm/value/LSNull.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../value/Function.hpp"
+#include "../value/FunctionCall.hpp"
 
 using namespace std;
 
@@ -33,13 +34,29 @@ void Return::analyse(SemanticAnalyser* analyser, const Type& req_type) {
 	if (f != nullptr) {
 		function = f;
 		in_function = true;
+		if (expression->type.nature != Nature::UNKNOWN) {
+			f->returns = f->returns.nature == Nature::UNKNOWN ? expression->type : f->returns.mix(expression->type);
+		}
 	}
 	type = expression->type;
 }
 
+void Return::fold() {
+	expression->fold();
+}
+
 jit_value_t Return::compile_jit(Compiler& c, jit_function_t& F, Type type) const {
 
+	FunctionCall* call = dynamic_cast<FunctionCall*>(expression);
+	if (call != nullptr and call->compile_tail_call(c, F, function)) {
+		// Never reached : the function has started again
+		return type.nature == Nature::POINTER ? JIT_CREATE_CONST_POINTER(F, LSNull::null_var)
+			: jit_value_create_nint_constant(F, JIT_INTEGER, 0);
+	}
+
 	jit_value_t v = expression->compile_jit(c, F, type);
+	bool pointer = type.nature == Nature::POINTER or expression->type.nature == Nature::POINTER;
+	c.delete_function_vars(F, pointer ? v : nullptr);
 	jit_insn_return(F, v);
 	return v;
 }
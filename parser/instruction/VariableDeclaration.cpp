@@ -1,6 +1,7 @@
 #include "VariableDeclaration.hpp"
 #include "../../vm/VM.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
+#include "../value/Function.hpp"
 
 using namespace std;
 
@@ -35,6 +36,13 @@ void VariableDeclaration::print(ostream& os) const {
 
 void VariableDeclaration::analyse(SemanticAnalyser* analyser, const Type&) {
 
+	// A function can call itself : its variable is declared before its body is analysed
+	for (unsigned i = 0; i < variables.size() and i < expressions.size(); ++i) {
+		if (dynamic_cast<Function*>(expressions[i]) != nullptr) {
+			declare(analyser, variables[i], expressions[i]->type, expressions[i]);
+		}
+	}
+
 	type = Type::VALUE;
 	for (unsigned i = 0; i < expressions.size(); ++i) {
 		expressions[i]->analyse(analyser, Type::NEUTRAL);
@@ -52,19 +60,31 @@ void VariableDeclaration::analyse(SemanticAnalyser* analyser, const Type&) {
 			value = expressions[i];
 		}
 
-		// Global Variable already defined ? We don't define another time
-		if (vars.find(var->content) == vars.end() || vars.at(var->content)->scope != VarScope::GLOBAL) {
-			SemanticVar* v = analyser->add_var(var, type, value);
-			vars.insert(pair<string, SemanticVar*>(var->content, v));
-		}
+		declare(analyser, var, type, value);
 		vars.at(var->content)->type = type;
 	}
 	this->return_value = return_value;
 }
 
-extern map<string, jit_value_t> globals;
-extern map<string, Type> globals_types;
-extern map<string, jit_value_t> locals;
+void VariableDeclaration::fold() {
+	for (Value* expression : expressions) {
+		if (expression != nullptr) {
+			expression->fold();
+		}
+	}
+}
+
+void VariableDeclaration::declare(SemanticAnalyser* analyser, Token* var, const Type& type, Value* value) {
+
+	// Global variable already defined, or function variable declared before its
+	// body ? We don't define another time
+	auto v = vars.find(var->content);
+	if (v != vars.end() and (v->second->scope == VarScope::GLOBAL
+		or analyser->get_var_direct(var->content) == v->second)) {
+		return;
+	}
+	vars[var->content] = analyser->add_var(var, type, value);
+}
 
 jit_value_t VariableDeclaration::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
 
@@ -76,13 +96,24 @@ jit_value_t VariableDeclaration::compile_jit(Compiler& c, jit_function_t& F, Typ
 
 //			cout << "add global var : " << variables[i] << endl;
 
-			jit_value_t var = jit_value_create(F, JIT_INTEGER_LONG);
-			globals.insert(pair<string, jit_value_t>(variables[i]->content, var));
+			// Pointer variables are created by the program, which owns their values
+			auto g = c.globals.find(variables[i]->content);
+			bool owned = g != c.globals.end() and c.is_function_var(g->second);
+			jit_value_t var = owned ? g->second : jit_value_create(F, JIT_INTEGER_LONG);
+			c.globals[variables[i]->content] = var;
+
 			if (i < expressions.size()) {
 
 				jit_value_t val = expressions.at(i)->compile_jit(c, F, Type::NEUTRAL);
-				globals_types.insert(pair<string, Type>(variables[i]->content, expressions[i]->type));
-				jit_insn_store(F, var, val);
+				c.globals_types[variables[i]->content] = expressions[i]->type;
+				if (owned and expressions[i]->type.nature == Nature::POINTER) {
+					val = VM::store_value(F, var, val);
+				} else if (owned) {
+					jit_value_t ptr = VM::value_to_pointer(F, val, expressions[i]->type);
+					VM::store_value(F, var, ptr);
+				} else {
+					jit_insn_store(F, var, val);
+				}
 
 				if (i == expressions.size() - 1) {
 					if (expressions[i]->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
@@ -92,20 +123,48 @@ jit_value_t VariableDeclaration::compile_jit(Compiler& c, jit_function_t& F, Typ
 				}
 			} else {
 
-				globals_types.insert(pair<string, Type>(variables[i]->content, Type::NULLL));
+				c.globals_types[variables[i]->content] = Type::NULLL;
 				jit_value_t val = JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
-				jit_insn_store(F, var, val);
+				if (owned) {
+					jit_value_t old = jit_insn_load(F, var);
+					jit_insn_store(F, var, val);
+					VM::delete_ref(F, old);
+				} else {
+					jit_insn_store(F, var, val);
+				}
+			}
+		} else if (i < expressions.size() and expressions[i] == v->value and v->scalar_replaced()) {
+
+			// The literal doesn't escape : only its elements are computed
+			vector<jit_value_t>& elements = c.scalar_elements[v];
+			elements.clear();
+			for (Value* element : *v->literal_elements()) {
+				jit_value_t e = jit_value_create(F, element->type.raw_type == RawType::FLOAT ? JIT_FLOAT : JIT_INTEGER);
+				jit_insn_store(F, e, element->compile_jit(c, F, Type::NEUTRAL));
+				elements.push_back(e);
+			}
+			if (i == variables.size() - 1) {
+				return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
 			}
 		} else {
 
-			jit_value_t var = jit_value_create(F, JIT_INTEGER);
-			locals.insert(pair<string, jit_value_t>(variables[i]->content, var));
+			auto l = c.locals.find(variables[i]->content);
+			bool owned = l != c.locals.end() and c.is_function_var(l->second);
+			jit_value_t var = owned ? l->second : jit_value_create(F, JIT_INTEGER);
+			c.locals[variables[i]->content] = var;
 
 			if (i < expressions.size()) {
 
 				jit_value_t val = expressions.at(i)->compile_jit(c, F, Type::NEUTRAL);
 
-				jit_insn_store(F, var, val);
+				if (owned and expressions[i]->type.nature == Nature::POINTER) {
+					val = VM::store_value(F, var, val);
+				} else if (owned) {
+					jit_value_t ptr = VM::value_to_pointer(F, val, expressions[i]->type);
+					VM::store_value(F, var, ptr);
+				} else {
+					jit_insn_store(F, var, val);
+				}
 
 				if (i == variables.size() - 1) {
 					if (expressions[i]->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
@@ -116,7 +175,13 @@ jit_value_t VariableDeclaration::compile_jit(Compiler& c, jit_function_t& F, Typ
 			} else {
 
 				jit_value_t val = JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
-				jit_insn_store(F, var, val);
+				if (owned) {
+					jit_value_t old = jit_insn_load(F, var);
+					jit_insn_store(F, var, val);
+					VM::delete_ref(F, old);
+				} else {
+					jit_insn_store(F, var, val);
+				}
 				return val;
 			}
 		}
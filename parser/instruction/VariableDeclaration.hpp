@@ -24,6 +24,8 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type& req_type) override;
+	virtual void fold() override;
+	void declare(SemanticAnalyser*, Token* var, const Type&, Value* value);
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 };
@@ -2,6 +2,7 @@
 #include "While.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../value/Number.hpp"
+#include "LoopMotion.hpp"
 
 using namespace std;
 
@@ -22,10 +23,19 @@ void While::print(ostream& os) const {
 
 void While::analyse(SemanticAnalyser* analyser, const Type& req_type) {
 
+	loop_depth = ++analyser->loop_depth;
+
 	if (condition != nullptr) {
 		condition->analyse(analyser);
 	}
 	body->analyse(analyser, req_type);
+
+	analyser->loop_depth--;
+}
+
+void While::fold() {
+	condition->fold();
+	body->fold();
 }
 
 int while_is_true(LSValue* v) {
@@ -34,16 +44,22 @@ int while_is_true(LSValue* v) {
 
 jit_value_t While::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 
+	jit_label_t label_preheader = jit_label_undefined;
 	jit_label_t label_cond = jit_label_undefined;
 	jit_label_t label_end = jit_label_undefined;
 	jit_value_t const_true = JIT_CREATE_CONST(F, JIT_INTEGER, 1);
 	jit_type_t args_types[1] = {JIT_POINTER};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_types, 1, 0);
 
+	LoopMotion motion(c, loop_depth);
+	c.loop_motions.push_back(&motion);
 	c.enter_loop(&label_end, &label_cond);
 
+	jit_insn_branch(F, &label_preheader);
+
 	// cond label:
 	jit_insn_label(F, &label_cond);
+	c.vm->inc_ops(F, body->operations());
 
 	// condition
 	jit_value_t cond = condition->compile_jit(c, F, Type::NEUTRAL);
@@ -63,10 +79,16 @@ jit_value_t While::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 	// jump to cond
 	jit_insn_branch(F, &label_cond);
 
+	// preheader, run once before the first condition
+	jit_insn_label(F, &label_preheader);
+	motion.compile_preheader(c, F);
+	jit_insn_branch(F, &label_cond);
+
 	// end label:
 	jit_insn_label(F, &label_end);
 
 	c.leave_loop();
+	c.loop_motions.pop_back();
 
 	return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
 }
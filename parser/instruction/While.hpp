@@ -14,6 +14,7 @@ public:
 
 	Value* condition;
 	Body* body;
+	int loop_depth;
 
 	While();
 	virtual ~While();
@@ -21,6 +22,7 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type& req_type) override;
+	virtual void fold() override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 };
@@ -51,7 +51,10 @@ static vector<string> type_literals[] = {
 
 	{ "~" }, { "~=" }, { "~~" }, { "~~=" },
 
-	{ "π" }
+	{ "π" },
+
+	{ "~+" }, { "~-" }, { "~*", "~×" }, { "~/", "~÷" },
+	{ "~+=" }, { "~-=" }, { "~*=", "~×=" }, { "~/=", "~÷=" }
 };
 
 LexicalAnalyser::LexicalAnalyser() {}
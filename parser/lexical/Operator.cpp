@@ -10,9 +10,9 @@ using namespace std;
  * ------------------
  * 1| ^
  * ------------------
- * 2| * / %
+ * 2| * / % ~* ~/
  * ------------------
- * 3| + -
+ * 3| + - ~+ ~-
  * ------------------
  * 4| < <= > >=
  * ------------------
@@ -22,7 +22,7 @@ using namespace std;
  * ------------------
  * 7| || or xor
  * ------------------
- * 8| = += -= *= /= %= ^= <=>
+ * 8| = += -= *= /= %= ^= <=> ~+= ~-= ~*= ~/=
  */
 
 static int operator_priorities[] = {
@@ -48,11 +48,17 @@ static int operator_priorities[] = {
 	8, 8, /* ^= %= */
 	2, /* % */
 	0, 0, 0, 0, 0, 0, 0,
-	0, 0, 0, 0 /* ~ ~~ ~= ~~= */
+	0, 0, 0, 0, /* ~ ~~ ~= ~~= */
+	0,
+	3, 3, /* ~+ ~- */
+	2, 2, /* ~* ~/ */
+	8, 8, 8, 8 /* ~+= ~-= ~*= ~/= */
 };
+static_assert(sizeof(operator_priorities) / sizeof(int) == TOKEN_TYPES, "A priority for each token type");
 
 Operator::Operator(Token* token) {
 
+	this->token = token;
 	this->type = token->type;
 	this->character = token->content;
 	this->priority = operator_priorities[(int) token->type];
@@ -6,6 +6,7 @@
 class Operator {
 public:
 
+	Token* token;
 	TokenType type;
 	std::string character;
 	int priority;
@@ -0,0 +1,129 @@
+#include "TokenFile.hpp"
+#include "LexicalAnalyser.hpp"
+#include "../syntaxic/SyntaxicAnalyser.hpp"
+#include "../syntaxic/TreeFile.hpp"
+#include "../../vm/Sha256.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const char TokenFile::MAGIC[4] = {'L', 'S', 'C', '2'};
+
+static const size_t DIGEST_SIZE = 32;
+
+static void write_u32(string& out, uint32_t value) {
+	out.append((const char*) &value, sizeof(value));
+}
+
+/*
+ * A script with syntax errors is not saved : its tree is incomplete
+ */
+bool TokenFile::save(const string& path, const string& code) {
+
+	LexicalAnalyser lex;
+	vector<Token> tokens = lex.analyse(code);
+	SyntaxicAnalyser syn;
+	unique_ptr<Program> program(syn.analyse(tokens));
+	if (syn.getErrors().size() > 0) {
+		return false;
+	}
+
+	string content;
+	write_u32(content, tokens.size());
+	for (Token& token : tokens) {
+		write_u32(content, (uint32_t) token.type);
+		write_u32(content, token.line);
+		write_u32(content, token.character);
+		write_u32(content, token.size);
+		write_u32(content, token.content.size());
+		content.append(token.content);
+	}
+	if (!TreeFile::write(content, program.get(), syn.getTokens())) {
+		return false;
+	}
+
+	ofstream out(path, ios::binary);
+	if (!out) {
+		return false;
+	}
+	out.write(MAGIC, sizeof(MAGIC));
+	out << sha256(content) << content;
+	return out.good();
+}
+
+bool TokenFile::load(const string& path, vector<Token>& tokens, Program*& program, string& digest) {
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 or st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	MappedReader reader((const char*) data, st.st_size);
+
+	// The digest of the content must be the one computed again
+	char magic[sizeof(MAGIC)];
+	char stored_digest[DIGEST_SIZE];
+	bool valid = reader.read(magic, sizeof(magic)) and memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+		and reader.read(stored_digest, DIGEST_SIZE)
+		and sha256(string(reader.data + reader.position, reader.size - reader.position)) == string(stored_digest, DIGEST_SIZE);
+
+	uint32_t count = 0;
+	valid = valid and reader.read(&count, sizeof(count));
+
+	tokens.clear();
+	for (uint32_t i = 0; valid and i < count; ++i) {
+
+		uint32_t type, line, character, size, length;
+		valid = reader.read(&type, 4) and type < TOKEN_TYPES and reader.read(&line, 4)
+			and reader.read(&character, 4) and reader.read(&size, 4) and reader.read(&length, 4)
+			and length <= reader.size - reader.position;
+		if (!valid) break;
+
+		Token token;
+		token.type = (TokenType) type;
+		token.line = line;
+		token.character = character;
+		token.size = size;
+		token.content.assign(reader.data + reader.position, length);
+		reader.position += length;
+		tokens.push_back(token);
+	}
+
+	// The nodes point to the tokens, all read before
+	program = valid ? TreeFile::read(reader, tokens) : nullptr;
+	valid = program != nullptr and reader.position == reader.size;
+	munmap(data, st.st_size);
+
+	if (!valid) {
+		delete program;
+		program = nullptr;
+		tokens.clear();
+		return false;
+	}
+	ostringstream oss;
+	oss << hex << setfill('0');
+	for (unsigned char c : string(stored_digest, DIGEST_SIZE)) {
+		oss << setw(2) << (int) c;
+	}
+	digest = oss.str();
+	return true;
+}
@@ -0,0 +1,48 @@
+#ifndef TOKENFILE_HPP_
+#define TOKENFILE_HPP_
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include "Token.hpp"
+
+class Program;
+
+/*
+ * Precompiled script (.lsc) : the tokens of a source file and its syntax
+ * tree (see TreeFile), stored in a compact binary format and mapped in memory
+ * to be loaded without running the lexical and syntaxic analyses. The file
+ * starts with the SHA-256 digest of its content, checked when it's loaded :
+ * it identifies the program in the compiled programs cache of the VM.
+ */
+class TokenFile {
+public:
+
+	static const char MAGIC[4];
+
+	static bool save(const std::string& path, const std::string& code);
+	static bool load(const std::string& path, std::vector<Token>& tokens, Program*& program, std::string& digest);
+};
+
+/*
+ * Reads the values of a mapped file, checking that they are in it
+ */
+class MappedReader {
+public:
+	const char* data;
+	size_t size;
+	size_t position;
+
+	MappedReader(const char* data, size_t size) : data(data), size(size), position(0) {}
+
+	bool read(void* value, size_t length) {
+		if (length > size - position) {
+			return false;
+		}
+		memcpy(value, data + position, length);
+		position += length;
+		return true;
+	}
+};
+
+#endif
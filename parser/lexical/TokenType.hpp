@@ -84,7 +84,18 @@ enum class TokenType {
 	TILDE_EQUAL,
 	TILDE_TILDE,
 	TILDE_TILDE_EQUAL,
-	PI
+	PI,
+	TILDE_PLUS,
+	TILDE_MINUS,
+	TILDE_TIMES,
+	TILDE_DIVIDE,
+	TILDE_PLUS_EQUAL,
+	TILDE_MINUS_EQUAL,
+	TILDE_TIMES_EQUAL,
+	TILDE_DIVIDE_EQUAL
 };
 
+// Number of token types : the types read from a file are checked against it
+static const unsigned TOKEN_TYPES = (unsigned) TokenType::TILDE_DIVIDE_EQUAL + 1;
+
 #endif
@@ -7,6 +7,10 @@
 #include "../../vm/standard/StringSTD.hpp"
 #include "../../vm/standard/ArraySTD.hpp"
 #include "../../vm/standard/ObjectSTD.hpp"
+#include "../value/Array.hpp"
+#include "../value/Object.hpp"
+#include "../value/ArrayAccess.hpp"
+#include "../value/ObjectAccess.hpp"
 
 using namespace std;
 
@@ -30,6 +34,44 @@ void SemanticVar::will_take(SemanticAnalyser* analyser, unsigned pos, const Type
 	}
 }
 
+/*
+ * Elements of the array or object literal value of the variable, nullptr
+ * if its value is not a literal or has explicit keys
+ */
+const vector<Value*>* SemanticVar::literal_elements() const {
+	if (Array* array = dynamic_cast<Array*>(value)) {
+		return array->associative ? nullptr : &array->expressions;
+	}
+	if (Object* object = dynamic_cast<Object*>(value)) {
+		return &object->values;
+	}
+	return nullptr;
+}
+
+// Bigger literals are built : a variable for each element would cost more
+static const unsigned MAX_SCALAR_ELEMENTS = 8;
+
+/*
+ * Escape analysis : a local array or object literal, never modified, only
+ * read by elements with constant keys, is never built. Its numbers and
+ * booleans are kept in variables.
+ */
+bool SemanticVar::scalar_replaced() const {
+
+	const vector<Value*>* elements = literal_elements();
+	if (scope != VarScope::LOCAL or assignments > 0 or uses != element_uses or elements == nullptr
+		or elements->size() > MAX_SCALAR_ELEMENTS) {
+		return false;
+	}
+	for (Value* element : *elements) {
+		if (element->type.nature != Nature::VALUE or (element->type.raw_type != RawType::INTEGER
+			and element->type.raw_type != RawType::FLOAT and element->type.raw_type != RawType::BOOLEAN)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 extern LSValue* jit_add(LSValue* x, LSValue* y);
 extern LSValue* jit_sub(LSValue* x, LSValue* y);
 extern LSValue* jit_mul(LSValue* x, LSValue* y);
@@ -41,25 +83,25 @@ void SemanticAnalyser::analyse(Program* program, Context* context) {
 	this->program = program;
 
 	// Add context variables
-	for (auto var : context->vars) {
-		add_global_var(new Token(var.first), Type(var.second->getRawType(), Nature::POINTER), nullptr);
+	for (auto var : context->types()) {
+		add_global_var(new Token(var.first), Type(var.second, Nature::POINTER), nullptr);
 	}
 
 	Type op_type = Type(RawType::FUNCTION, Nature::POINTER);
 	op_type.setArgumentType(0, Type::POINTER);
 	op_type.setArgumentType(1, Type::POINTER);
 	op_type.setReturnType(Type::POINTER);
-	program->system_vars.insert(pair<string, LSValue*>("+", new LSFunction((void*) &jit_add)));
+	program->system_vars.insert(pair<string, LSValue*>("+", make_native(new LSFunction((void*) &jit_add))));
 	add_var(new Token("+"), op_type, nullptr);
-	program->system_vars.insert(pair<string, LSValue*>("-", new LSFunction((void*) &jit_sub)));
+	program->system_vars.insert(pair<string, LSValue*>("-", make_native(new LSFunction((void*) &jit_sub))));
 	add_var(new Token("-"), op_type, nullptr);
-	program->system_vars.insert(pair<string, LSValue*>("*", new LSFunction((void*) &jit_mul)));
+	program->system_vars.insert(pair<string, LSValue*>("*", make_native(new LSFunction((void*) &jit_mul))));
 	add_var(new Token("*"), op_type, nullptr);
-	program->system_vars.insert(pair<string, LSValue*>("/", new LSFunction((void*) &jit_div)));
+	program->system_vars.insert(pair<string, LSValue*>("/", make_native(new LSFunction((void*) &jit_div))));
 	add_var(new Token("/"), op_type, nullptr);
-	program->system_vars.insert(pair<string, LSValue*>("^", new LSFunction((void*) &jit_pow)));
+	program->system_vars.insert(pair<string, LSValue*>("^", make_native(new LSFunction((void*) &jit_pow))));
 	add_var(new Token("^"), op_type, nullptr);
-	program->system_vars.insert(pair<string, LSValue*>("%", new LSFunction((void*) &jit_mod)));
+	program->system_vars.insert(pair<string, LSValue*>("%", make_native(new LSFunction((void*) &jit_mod))));
 	add_var(new Token("%"), op_type, nullptr);
 
 	Type print_type = Type(RawType::FUNCTION, Nature::POINTER);
@@ -77,7 +119,20 @@ void SemanticAnalyser::analyse(Program* program, Context* context) {
 	do {
 //		cout << "--------" << endl << "Analyse" << endl << "--------" << endl;
 		reanalyse = false;
+		element_reads.clear();
 		program->body->analyse(this, Type::POINTER);
+
+		// The last analysis of a read decides, it's the one compiled
+		map<bool*, bool> scalar_reads;
+		for (auto read : element_reads) {
+			scalar_reads[read.second] = read.first->scalar_replaced();
+		}
+		for (auto read : scalar_reads) {
+			if (*read.first != read.second) {
+				*read.first = read.second;
+				reanalyse = true;
+			}
+		}
 	} while (reanalyse);
 
 	program->functions = functions;
@@ -108,6 +163,7 @@ Function* SemanticAnalyser::current_function() const {
 SemanticVar* SemanticAnalyser::add_parameter(Token* v, Type type) {
 
 	SemanticVar* arg = new SemanticVar(VarScope::PARAMETER, type, parameters.back().size(), nullptr);
+	arg->loop_depth = loop_depth;
 	parameters.back().insert(pair<string, SemanticVar*>(v->content, arg));
 	return arg;
 }
@@ -159,22 +215,28 @@ SemanticVar* SemanticAnalyser::add_var(Token* v, Type type, Value* value) {
 
 		if (in_function) {
 	//		cout << "local" << endl;
-			local_vars.back().insert(pair<string, SemanticVar*>(
+			auto declared = local_vars.back().insert(pair<string, SemanticVar*>(
 				v->content,
 				new SemanticVar(VarScope::LOCAL, type, 0, value)
 			));
-			return local_vars.back().at(v->content);
+			SemanticVar* var = declared.first->second;
+			if (declared.second) {
+				var->loop_depth = loop_depth;
+			} else {
+				// Declared again in the function : the variable takes another value
+				var->assignments++;
+			}
+			return var;
 		} else {
 //			cout << "global" << endl;
 
 			if (global_vars.find(v->content) != global_vars.end()) {
 				throw SemanticError(v, "Variable « " + v->content + " » is already defined!");
 			}
-			global_vars.insert(pair<string, SemanticVar*>(
-				v->content,
-				new SemanticVar(VarScope::GLOBAL, type, 0, value)
-			));
-			return global_vars.at(v->content);
+			SemanticVar* var = new SemanticVar(VarScope::GLOBAL, type, 0, value);
+			var->loop_depth = loop_depth;
+			global_vars.insert(pair<string, SemanticVar*>(v->content, var));
+			return var;
 		}
 	} else {
 		internal_vars.insert(pair<string, SemanticVar*>(
@@ -192,3 +254,30 @@ void SemanticAnalyser::add_function(Function* l) {
 map<string, SemanticVar*>& SemanticAnalyser::get_local_vars() {
 	return local_vars.back();
 }
+
+/*
+ * Variable whose value is changed by an assignment to a left value : a, a[0], a.b[1]...
+ */
+SemanticVar* SemanticAnalyser::assigned_var(Value* left_value) {
+	while (true) {
+		if (ArrayAccess* aa = dynamic_cast<ArrayAccess*>(left_value)) {
+			left_value = aa->array;
+		} else if (ObjectAccess* oa = dynamic_cast<ObjectAccess*>(left_value)) {
+			left_value = oa->object;
+		} else {
+			break;
+		}
+	}
+	VariableValue* vv = dynamic_cast<VariableValue*>(left_value);
+	return vv != nullptr ? vv->var : nullptr;
+}
+
+/*
+ * The value of an array access changed in place (a[0] += 1, a[0]++) must be
+ * the one in the array : it's accessed by reference
+ */
+void SemanticAnalyser::changed_in_place(Value* left_value) {
+	if (ArrayAccess* aa = dynamic_cast<ArrayAccess*>(left_value)) {
+		aa->in_place = true;
+	}
+}
@@ -17,10 +17,21 @@ public:
 	std::map<std::string, Type> attr_types;
 	int index;
 	Value* value;
+	// Assignments after its declaration : its value is not known when compiling
+	int assignments;
+	// Number of loops around its declaration
+	int loop_depth;
+	// Uses of the variable, and those only reading an element of its literal value
+	int uses;
+	int element_uses;
 	SemanticVar(VarScope scope, Type type, int index, Value* value) :
-		scope(scope), type(type), index(index), value(value) {}
+		scope(scope), type(type), index(index), value(value), assignments(0), loop_depth(0),
+		uses(0), element_uses(0) {}
 
 	void will_take(SemanticAnalyser*, unsigned, const Type&);
+
+	const std::vector<Value*>* literal_elements() const;
+	bool scalar_replaced() const;
 };
 
 class SemanticAnalyser {
@@ -30,6 +41,8 @@ public:
 	bool in_function = false;
 	bool in_program = false;
 	bool reanalyse = false;
+	// Number of loops around the code being analysed
+	int loop_depth = 0;
 
 	std::map<std::string, SemanticVar*> internal_vars;
 	std::map<std::string, SemanticVar*> global_vars;
@@ -39,6 +52,13 @@ public:
 	std::vector<Function*> functions;
 	std::stack<Function*> functions_stack;
 
+	/*
+	 * Reads of an element of the literal value of a variable, with their flag
+	 * typing them as the element : set after the analysis, once the variable
+	 * is known to be scalar replaced
+	 */
+	std::vector<std::pair<SemanticVar*, bool*>> element_reads;
+
 	SemanticAnalyser();
 	virtual ~SemanticAnalyser();
 
@@ -57,6 +77,9 @@ public:
 	SemanticVar* get_var_direct(std::string name);
 	std::map<std::string, SemanticVar*>& get_local_vars();
 
+	static SemanticVar* assigned_var(Value* left_value);
+	static void changed_in_place(Value* left_value);
+
 };
 
 #endif
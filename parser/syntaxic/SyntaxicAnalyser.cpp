@@ -43,7 +43,7 @@ Program* SyntaxicAnalyser::analyse(vector<Token>& tokens) {
 
 	this->tokens = tokens;
 	this->lt = nullptr;
-	this->t = &tokens.at(0);
+	this->t = &this->tokens.at(0);
 	this->nt = nullptr;
 	this->i = 0;
 
@@ -381,7 +381,11 @@ Value* SyntaxicAnalyser::eatExpression() {
 			t->type == TokenType::MODULO_EQUAL || t->type == TokenType::POWER_EQUAL ||
 			t->type == TokenType::SWAP || t->type == TokenType::TILDE ||
 			t->type == TokenType::TILDE_TILDE || t->type == TokenType::TILDE_EQUAL ||
-			t->type == TokenType::TILDE_TILDE_EQUAL || t->type == TokenType::IN) {
+			t->type == TokenType::TILDE_TILDE_EQUAL || t->type == TokenType::IN ||
+			t->type == TokenType::TILDE_PLUS || t->type == TokenType::TILDE_MINUS ||
+			t->type == TokenType::TILDE_TIMES || t->type == TokenType::TILDE_DIVIDE ||
+			t->type == TokenType::TILDE_PLUS_EQUAL || t->type == TokenType::TILDE_MINUS_EQUAL ||
+			t->type == TokenType::TILDE_TIMES_EQUAL || t->type == TokenType::TILDE_DIVIDE_EQUAL) {
 
 		if (t->type == TokenType::MINUS && t->line != lt->line && nt != nullptr && t->line == nt->line)
 			break;
@@ -918,6 +922,13 @@ vector<SyntaxicalError*> SyntaxicAnalyser::getErrors() {
 	return errors;
 }
 
+/*
+ * Tokens pointed by the nodes of the program analysed
+ */
+const vector<Token>& SyntaxicAnalyser::getTokens() const {
+	return tokens;
+}
+
 long SyntaxicAnalyser::getTime() {
 	return time;
 }
@@ -48,6 +48,7 @@ public:
 
 	long getTime();
 	std::vector<SyntaxicalError*> getErrors();
+	const std::vector<Token>& getTokens() const;
 };
 
 #endif
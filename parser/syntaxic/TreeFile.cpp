@@ -0,0 +1,631 @@
+#include "TreeFile.hpp"
+#include "../Body.hpp"
+#include "../value/AbsoluteValue.hpp"
+#include "../value/Array.hpp"
+#include "../value/ArrayAccess.hpp"
+#include "../value/Boolean.hpp"
+#include "../value/Expression.hpp"
+#include "../value/Function.hpp"
+#include "../value/FunctionCall.hpp"
+#include "../value/If.hpp"
+#include "../value/Nulll.hpp"
+#include "../value/Number.hpp"
+#include "../value/Object.hpp"
+#include "../value/ObjectAccess.hpp"
+#include "../value/PostfixExpression.hpp"
+#include "../value/PrefixExpression.hpp"
+#include "../value/Reference.hpp"
+#include "../value/String.hpp"
+#include "../value/VariableValue.hpp"
+#include "../instruction/Break.hpp"
+#include "../instruction/ClassDeclaration.hpp"
+#include "../instruction/Continue.hpp"
+#include "../instruction/ExpressionInstruction.hpp"
+#include "../instruction/For.hpp"
+#include "../instruction/Foreach.hpp"
+#include "../instruction/Return.hpp"
+#include "../instruction/VariableDeclaration.hpp"
+#include "../instruction/While.hpp"
+#include <cstdint>
+
+using namespace std;
+
+enum class Node : uint8_t {
+	NONE,
+	// Values
+	ABSOLUTE_VALUE, ARRAY, ARRAY_ACCESS, BOOLEAN, EXPRESSION, FUNCTION, FUNCTION_CALL,
+	IF, NULLL, NUMBER, OBJECT, OBJECT_ACCESS, POSTFIX, PREFIX, REFERENCE, STRING, VARIABLE,
+	// Instructions
+	BREAK, CLASS, CONTINUE, EXPRESSION_INSTRUCTION, FOR, FOREACH, RETURN, VARIABLE_DECLARATION, WHILE
+};
+
+// Deeper trees are not read : the reading is recursive
+static const int MAX_DEPTH = 4096;
+
+/*
+ * Writes the nodes. The tokens must be the ones of the script, a tree
+ * referring to another one (built after a syntax error) can't be written.
+ */
+class TreeWriter {
+public:
+	string& out;
+	const vector<Token>& tokens;
+	bool valid = true;
+
+	TreeWriter(string& out, const vector<Token>& tokens) : out(out), tokens(tokens) {}
+
+	void node(Node node) {
+		out.push_back((char) node);
+	}
+	void u32(uint32_t value) {
+		out.append((const char*) &value, sizeof(value));
+	}
+	void flag(bool value) {
+		out.push_back(value ? 1 : 0);
+	}
+	void string_(const string& s) {
+		u32(s.size());
+		out.append(s);
+	}
+	void token(const Token* token) {
+		if (tokens.empty() or token < &tokens.front() or token > &tokens.back()) {
+			valid = false;
+			return;
+		}
+		u32(token - &tokens.front());
+	}
+	void operator_(const Operator* op) {
+		flag(op != nullptr);
+		if (op != nullptr) token(op->token);
+	}
+
+	void body(const Body* body) {
+		if (body == nullptr) {
+			flag(false);
+			return;
+		}
+		flag(true);
+		u32(body->instructions.size());
+		for (Instruction* instruction : body->instructions) {
+			this->instruction(instruction);
+		}
+	}
+
+	void values(const vector<Value*>& values) {
+		u32(values.size());
+		for (Value* v : values) {
+			value(v);
+		}
+	}
+
+	void value(const Value* value) {
+
+		if (value == nullptr) {
+			node(Node::NONE);
+
+		} else if (auto v = dynamic_cast<const AbsoluteValue*>(value)) {
+			node(Node::ABSOLUTE_VALUE);
+			flag(v->parenthesis);
+			this->value(v->expression);
+
+		} else if (auto v = dynamic_cast<const Array*>(value)) {
+			node(Node::ARRAY);
+			flag(v->parenthesis);
+			u32(v->expressions.size());
+			for (size_t i = 0; i < v->expressions.size(); ++i) {
+				this->value(v->keys[i]);
+				this->value(v->expressions[i]);
+			}
+
+		} else if (auto v = dynamic_cast<const ArrayAccess*>(value)) {
+			node(Node::ARRAY_ACCESS);
+			flag(v->parenthesis);
+			this->value(v->array);
+			this->value(v->key);
+			this->value(v->key2);
+
+		} else if (auto v = dynamic_cast<const Boolean*>(value)) {
+			node(Node::BOOLEAN);
+			flag(v->parenthesis);
+			flag(v->value);
+
+		} else if (auto v = dynamic_cast<const Expression*>(value)) {
+			node(Node::EXPRESSION);
+			flag(v->parenthesis);
+			this->value(v->v1);
+			operator_(v->op);
+			this->value(v->v2);
+
+		} else if (auto v = dynamic_cast<const Function*>(value)) {
+			node(Node::FUNCTION);
+			flag(v->parenthesis);
+			flag(v->lambda);
+			u32(v->arguments.size());
+			// The arguments of a lambda have no references nor default values
+			for (size_t i = 0; i < v->arguments.size(); ++i) {
+				token(v->arguments[i]);
+				flag(i < v->references.size() and v->references[i]);
+				this->value(i < v->defaultValues.size() ? v->defaultValues[i] : nullptr);
+			}
+			body(v->body);
+
+		} else if (auto v = dynamic_cast<const FunctionCall*>(value)) {
+			node(Node::FUNCTION_CALL);
+			flag(v->parenthesis);
+			this->value(v->function);
+			values(v->arguments);
+
+		} else if (auto v = dynamic_cast<const If*>(value)) {
+			node(Node::IF);
+			flag(v->parenthesis);
+			this->value(v->condition);
+			body(v->then);
+			body(v->elze);
+
+		} else if (auto v = dynamic_cast<const Nulll*>(value)) {
+			node(Node::NULLL);
+			flag(v->parenthesis);
+
+		} else if (auto v = dynamic_cast<const Number*>(value)) {
+			node(Node::NUMBER);
+			flag(v->parenthesis);
+			out.append((const char*) &v->value, sizeof(v->value));
+
+		} else if (auto v = dynamic_cast<const Object*>(value)) {
+			node(Node::OBJECT);
+			flag(v->parenthesis);
+			u32(v->keys.size());
+			for (size_t i = 0; i < v->keys.size(); ++i) {
+				token(v->keys[i]->token);
+				this->value(v->values[i]);
+			}
+
+		} else if (auto v = dynamic_cast<const ObjectAccess*>(value)) {
+			node(Node::OBJECT_ACCESS);
+			flag(v->parenthesis);
+			this->value(v->object);
+			string_(v->field);
+
+		} else if (auto v = dynamic_cast<const PostfixExpression*>(value)) {
+			node(Node::POSTFIX);
+			flag(v->parenthesis);
+			this->value(v->expression);
+			operator_(v->operatorr);
+
+		} else if (auto v = dynamic_cast<const PrefixExpression*>(value)) {
+			node(Node::PREFIX);
+			flag(v->parenthesis);
+			operator_(v->operatorr);
+			this->value(v->expression);
+
+		} else if (auto v = dynamic_cast<const Reference*>(value)) {
+			node(Node::REFERENCE);
+			flag(v->parenthesis);
+			string_(v->variable);
+
+		} else if (auto v = dynamic_cast<const String*>(value)) {
+			node(Node::STRING);
+			flag(v->parenthesis);
+			string_(v->value);
+
+		} else if (auto v = dynamic_cast<const VariableValue*>(value)) {
+			node(Node::VARIABLE);
+			flag(v->parenthesis);
+			token(v->name);
+
+		} else {
+			// Nodes built by the later analyses
+			valid = false;
+		}
+	}
+
+	void instruction(const Instruction* instruction) {
+
+		if (instruction == nullptr) {
+			node(Node::NONE);
+
+		} else if (dynamic_cast<const Break*>(instruction)) {
+			node(Node::BREAK);
+
+		} else if (auto i = dynamic_cast<const ClassDeclaration*>(instruction)) {
+			node(Node::CLASS);
+			string_(i->name);
+			u32(i->fields.size());
+			for (VariableDeclaration* field : i->fields) {
+				this->instruction(field);
+			}
+
+		} else if (dynamic_cast<const Continue*>(instruction)) {
+			node(Node::CONTINUE);
+
+		} else if (auto i = dynamic_cast<const ExpressionInstruction*>(instruction)) {
+			node(Node::EXPRESSION_INSTRUCTION);
+			value(i->value);
+
+		} else if (auto i = dynamic_cast<const For*>(instruction)) {
+			node(Node::FOR);
+			u32(i->variables.size());
+			for (size_t v = 0; v < i->variables.size(); ++v) {
+				token(i->variables[v]);
+				flag(i->declare_variables[v]);
+				value(i->variablesValues[v]);
+			}
+			value(i->condition);
+			values(i->iterations);
+			body(i->body);
+
+		} else if (auto i = dynamic_cast<const Foreach*>(instruction)) {
+			node(Node::FOREACH);
+			flag(i->key != nullptr);
+			if (i->key != nullptr) token(i->key);
+			token(i->value);
+			value(i->array);
+			body(i->body);
+
+		} else if (auto i = dynamic_cast<const Return*>(instruction)) {
+			node(Node::RETURN);
+			value(i->expression);
+
+		} else if (auto i = dynamic_cast<const VariableDeclaration*>(instruction)) {
+			node(Node::VARIABLE_DECLARATION);
+			flag(i->global);
+			u32(i->variables.size());
+			for (Token* variable : i->variables) {
+				token(variable);
+			}
+			values(i->expressions);
+
+		} else if (auto i = dynamic_cast<const While*>(instruction)) {
+			node(Node::WHILE);
+			value(i->condition);
+			body(i->body);
+
+		} else {
+			valid = false;
+		}
+	}
+};
+
+/*
+ * Reads the nodes, checking the data : a node of an unknown kind or where
+ * another one is expected, a token out of the script, or data out of the
+ * file make the tree invalid
+ */
+class TreeReader {
+public:
+	MappedReader& reader;
+	vector<Token>& tokens;
+	bool valid = true;
+	int depth = 0;
+
+	TreeReader(MappedReader& reader, vector<Token>& tokens) : reader(reader), tokens(tokens) {}
+
+	Node node() {
+		uint8_t node = 0;
+		valid = valid and reader.read(&node, 1) and node <= (uint8_t) Node::WHILE;
+		return valid ? (Node) node : Node::NONE;
+	}
+	uint32_t u32() {
+		uint32_t value = 0;
+		valid = valid and reader.read(&value, sizeof(value));
+		return value;
+	}
+	// Counts of items : each one takes at least a byte of the file
+	uint32_t count() {
+		uint32_t count = u32();
+		valid = valid and count <= reader.size - reader.position;
+		return valid ? count : 0;
+	}
+	bool flag() {
+		uint8_t value = 0;
+		valid = valid and reader.read(&value, 1);
+		return value != 0;
+	}
+	string string_() {
+		uint32_t length = u32();
+		valid = valid and length <= reader.size - reader.position;
+		if (!valid) return "";
+		string s(reader.data + reader.position, length);
+		reader.position += length;
+		return s;
+	}
+	Token* token() {
+		uint32_t index = u32();
+		valid = valid and index < tokens.size();
+		return valid ? &tokens[index] : nullptr;
+	}
+	Operator* operator_() {
+		if (!flag()) return nullptr;
+		Token* t = token();
+		return valid ? new Operator(t) : nullptr;
+	}
+
+	Body* body() {
+		if (!flag()) return nullptr;
+		Body* body = new Body();
+		uint32_t count = this->count();
+		for (uint32_t i = 0; valid and i < count; ++i) {
+			body->instructions.push_back(instruction());
+		}
+		return body;
+	}
+
+	vector<Value*> values() {
+		vector<Value*> values;
+		uint32_t count = this->count();
+		for (uint32_t i = 0; valid and i < count; ++i) {
+			values.push_back(value());
+		}
+		return values;
+	}
+
+	// A value which can't be missing
+	Value* required_value() {
+		Value* v = value();
+		valid = valid and v != nullptr;
+		return v;
+	}
+
+	Value* value() {
+
+		Node node = this->node();
+		if (!valid or node == Node::NONE) {
+			return nullptr;
+		}
+		if (++depth > MAX_DEPTH) {
+			valid = false;
+			return nullptr;
+		}
+		bool parenthesis = flag();
+		Value* value = nullptr;
+
+		switch (node) {
+			case Node::ABSOLUTE_VALUE: {
+				AbsoluteValue* v = new AbsoluteValue();
+				v->expression = required_value();
+				value = v;
+				break;
+			}
+			case Node::ARRAY: {
+				Array* v = new Array();
+				uint32_t count = this->count();
+				for (uint32_t i = 0; valid and i < count; ++i) {
+					Value* key = this->value();
+					v->addValue(required_value(), key);
+				}
+				value = v;
+				break;
+			}
+			case Node::ARRAY_ACCESS: {
+				ArrayAccess* v = new ArrayAccess();
+				v->array = required_value();
+				v->key = required_value();
+				v->key2 = this->value();
+				value = v;
+				break;
+			}
+			case Node::BOOLEAN: {
+				value = new Boolean(flag());
+				break;
+			}
+			case Node::EXPRESSION: {
+				Expression* v = new Expression(this->value());
+				v->op = operator_();
+				v->v2 = this->value();
+				valid = valid and (v->op == nullptr) == (v->v2 == nullptr);
+				value = v;
+				break;
+			}
+			case Node::FUNCTION: {
+				Function* v = new Function();
+				v->lambda = flag();
+				uint32_t count = this->count();
+				for (uint32_t i = 0; valid and i < count; ++i) {
+					Token* argument = token();
+					bool reference = flag();
+					v->addArgument(argument, reference, this->value());
+				}
+				v->body = body();
+				valid = valid and v->body != nullptr;
+				value = v;
+				break;
+			}
+			case Node::FUNCTION_CALL: {
+				FunctionCall* v = new FunctionCall();
+				v->function = required_value();
+				v->arguments = values();
+				value = v;
+				break;
+			}
+			case Node::IF: {
+				If* v = new If();
+				v->condition = required_value();
+				v->then = body();
+				v->elze = body();
+				valid = valid and v->then != nullptr;
+				value = v;
+				break;
+			}
+			case Node::NULLL: {
+				value = new Nulll();
+				break;
+			}
+			case Node::NUMBER: {
+				double number = 0;
+				valid = valid and reader.read(&number, sizeof(number));
+				value = new Number(number);
+				break;
+			}
+			case Node::OBJECT: {
+				Object* v = new Object();
+				uint32_t count = this->count();
+				for (uint32_t i = 0; valid and i < count; ++i) {
+					v->keys.push_back(new Ident(token()));
+					v->values.push_back(required_value());
+				}
+				value = v;
+				break;
+			}
+			case Node::OBJECT_ACCESS: {
+				ObjectAccess* v = new ObjectAccess();
+				v->object = required_value();
+				v->field = string_();
+				value = v;
+				break;
+			}
+			case Node::POSTFIX: {
+				PostfixExpression* v = new PostfixExpression();
+				v->expression = dynamic_cast<LeftValue*>(this->value());
+				v->operatorr = operator_();
+				valid = valid and v->expression != nullptr and v->operatorr != nullptr;
+				value = v;
+				break;
+			}
+			case Node::PREFIX: {
+				PrefixExpression* v = new PrefixExpression();
+				v->operatorr = operator_();
+				v->expression = required_value();
+				valid = valid and v->operatorr != nullptr;
+				value = v;
+				break;
+			}
+			case Node::REFERENCE: {
+				Reference* v = new Reference();
+				v->variable = string_();
+				value = v;
+				break;
+			}
+			case Node::STRING: {
+				value = new String(string_());
+				break;
+			}
+			case Node::VARIABLE: {
+				value = new VariableValue(token());
+				break;
+			}
+			default:
+				valid = false;
+				return nullptr;
+		}
+		value->parenthesis = parenthesis;
+		depth--;
+		return value;
+	}
+
+	Instruction* instruction() {
+
+		Node node = this->node();
+		if (!valid) {
+			return nullptr;
+		}
+		if (++depth > MAX_DEPTH) {
+			valid = false;
+			return nullptr;
+		}
+		Instruction* instruction = nullptr;
+
+		switch (node) {
+			case Node::BREAK: {
+				instruction = new Break();
+				break;
+			}
+			case Node::CLASS: {
+				ClassDeclaration* i = new ClassDeclaration();
+				i->name = string_();
+				uint32_t count = this->count();
+				for (uint32_t f = 0; valid and f < count; ++f) {
+					VariableDeclaration* field = dynamic_cast<VariableDeclaration*>(this->instruction());
+					valid = valid and field != nullptr;
+					i->fields.push_back(field);
+				}
+				instruction = i;
+				break;
+			}
+			case Node::CONTINUE: {
+				instruction = new Continue();
+				break;
+			}
+			case Node::EXPRESSION_INSTRUCTION: {
+				instruction = new ExpressionInstruction(required_value());
+				break;
+			}
+			case Node::FOR: {
+				For* i = new For();
+				uint32_t count = this->count();
+				for (uint32_t v = 0; valid and v < count; ++v) {
+					i->variables.push_back(token());
+					i->declare_variables.push_back(flag());
+					i->variablesValues.push_back(value());
+				}
+				i->condition = value();
+				i->iterations = values();
+				i->body = body();
+				valid = valid and i->body != nullptr;
+				instruction = i;
+				break;
+			}
+			case Node::FOREACH: {
+				Foreach* i = new Foreach();
+				if (flag()) {
+					i->key = token();
+				}
+				i->value = token();
+				i->array = required_value();
+				i->body = body();
+				valid = valid and i->body != nullptr;
+				instruction = i;
+				break;
+			}
+			case Node::RETURN: {
+				instruction = new Return(required_value());
+				break;
+			}
+			case Node::VARIABLE_DECLARATION: {
+				VariableDeclaration* i = new VariableDeclaration();
+				i->global = flag();
+				uint32_t count = this->count();
+				for (uint32_t v = 0; valid and v < count; ++v) {
+					i->variables.push_back(token());
+				}
+				i->expressions = values();
+				valid = valid and i->expressions.size() <= i->variables.size();
+				instruction = i;
+				break;
+			}
+			case Node::WHILE: {
+				While* i = new While();
+				i->condition = required_value();
+				i->body = body();
+				valid = valid and i->body != nullptr;
+				instruction = i;
+				break;
+			}
+			default:
+				valid = false;
+				return nullptr;
+		}
+		depth--;
+		return instruction;
+	}
+};
+
+bool TreeFile::write(string& out, const Program* program, const vector<Token>& tokens) {
+	TreeWriter writer(out, tokens);
+	writer.body(program->body);
+	return writer.valid;
+}
+
+/*
+ * Reads a tree refering to the tokens, which must stay where they are while
+ * the program is used. The nodes of an invalid tree are not deleted.
+ */
+Program* TreeFile::read(MappedReader& reader, vector<Token>& tokens) {
+	TreeReader tree(reader, tokens);
+	Body* body = tree.body();
+	if (!tree.valid or body == nullptr) {
+		return nullptr;
+	}
+	Program* program = new Program();
+	program->body = body;
+	return program;
+}
@@ -0,0 +1,22 @@
+#ifndef TREEFILE_HPP
+#define TREEFILE_HPP
+
+#include <vector>
+#include <string>
+#include "../lexical/Token.hpp"
+#include "../lexical/TokenFile.hpp"
+#include "../Program.hpp"
+
+/*
+ * Syntax tree of a precompiled script (see TokenFile) : the nodes built by
+ * the syntaxic analysis, stored in a binary format with their tokens given
+ * by their index in the tokens of the script
+ */
+class TreeFile {
+public:
+
+	static bool write(std::string& out, const Program* program, const std::vector<Token>& tokens);
+	static Program* read(MappedReader& reader, std::vector<Token>& tokens);
+};
+
+#endif
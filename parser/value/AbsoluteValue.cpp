@@ -19,8 +19,14 @@ void AbsoluteValue::analyse(SemanticAnalyser* analyser, const Type) {
 	constant = expression->constant;
 }
 
+void AbsoluteValue::fold() {
+	expression->fold();
+}
+
 LSValue* abso(LSValue* v) {
-	return v->abso();
+	LSValue* r = v->abso();
+	if (r != v) LSValue::delete_temporary(v);
+	return r;
 }
 
 jit_value_t AbsoluteValue::compile_jit(Compiler& c, jit_function_t& F, Type) const {
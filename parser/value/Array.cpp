@@ -75,6 +75,17 @@ void Array::analyse(SemanticAnalyser* analyser, const Type) {
 //	cout << "Array type : " << type << endl;
 }
 
+void Array::fold() {
+	for (Value* key : keys) {
+		if (key != nullptr) {
+			key->fold();
+		}
+	}
+	for (Value* expression : expressions) {
+		expression->fold();
+	}
+}
+
 void Array::elements_will_take(SemanticAnalyser* analyser, const unsigned pos, const Type& type, int level) {
 
 	for (unsigned i = 0; i < expressions.size(); ++i) {
@@ -88,15 +99,77 @@ void Array::elements_will_take(SemanticAnalyser* analyser, const unsigned pos, c
 	}
 }
 
+/*
+ * A non empty list of integers or of floats can be stored unboxed
+ */
+RawType Array::unboxed_type() const {
+
+	if (associative or expressions.size() == 0 or !type.homogeneous) {
+		return RawType::UNKNOWN;
+	}
+	RawType raw_type = expressions[0]->type.raw_type;
+	if (raw_type != RawType::INTEGER and raw_type != RawType::FLOAT) {
+		return RawType::UNKNOWN;
+	}
+	for (Value* ex : expressions) {
+		if (ex->type.nature != Nature::VALUE or ex->type.raw_type != raw_type) {
+			return RawType::UNKNOWN;
+		}
+	}
+	return raw_type;
+}
+
 LSArray* LSArray_create() {
 	return new LSArray();
 }
 void LSArray_push(LSArray* array, LSValue* value) {
-	array->pushClone(value);
+	array->pushMove(value);
+}
+LSArray* LSArray_create_ints(int size) {
+	LSArray* array = new LSArray(RawType::INTEGER);
+	array->ints.reserve(size);
+	return array;
+}
+void LSArray_push_int(LSArray* array, int value) {
+	array->ints.push_back(value);
+	array->index++;
+}
+LSArray* LSArray_create_reals(int size) {
+	LSArray* array = new LSArray(RawType::FLOAT);
+	array->reals.reserve(size);
+	return array;
+}
+void LSArray_push_real(LSArray* array, double value) {
+	array->reals.push_back(value);
+	array->index++;
 }
 
 jit_value_t Array::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 
+	RawType unboxed = unboxed_type();
+	if (unboxed != RawType::UNKNOWN) {
+
+		bool isfloat = unboxed == RawType::FLOAT;
+		jit_type_t value_type = isfloat ? JIT_FLOAT : JIT_INTEGER;
+
+		jit_type_t create_args[1] = {JIT_INTEGER};
+		jit_type_t create_sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, create_args, 1, 0);
+		jit_value_t size = JIT_CREATE_CONST(F, JIT_INTEGER, expressions.size());
+		jit_value_t array = jit_insn_call_native(F, "new", isfloat ? (void*) LSArray_create_reals : (void*) LSArray_create_ints,
+			create_sig, &size, 1, JIT_CALL_NOTHROW);
+
+		jit_type_t push_args[2] = {JIT_POINTER, value_type};
+		jit_type_t push_sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, push_args, 2, 0);
+
+		for (Value* val : expressions) {
+			jit_value_t v = val->compile_jit(c, F, isfloat ? Type::FLOAT : Type::INTEGER);
+			jit_value_t args_v[] = {array, v};
+			jit_insn_call_native(F, "push", isfloat ? (void*) LSArray_push_real : (void*) LSArray_push_int,
+				push_sig, args_v, 2, JIT_CALL_NOTHROW);
+		}
+		return array;
+	}
+
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, {}, 0, 0);
 	jit_value_t array = jit_insn_call_native(F, "new", (void*) LSArray_create, sig, {}, 0, JIT_CALL_NOTHROW);
 
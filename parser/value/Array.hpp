@@ -20,8 +20,10 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 
 	void elements_will_take(SemanticAnalyser*, const unsigned, const Type&, int level);
+	RawType unboxed_type() const;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 };
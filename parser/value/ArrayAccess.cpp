@@ -1,5 +1,8 @@
 #include "ArrayAccess.hpp"
 #include "Array.hpp"
+#include "Number.hpp"
+#include "VariableValue.hpp"
+#include "../semantic/SemanticAnalyser.hpp"
 #include "../../vm/value/LSNull.hpp"
 #include "../../vm/value/LSArray.hpp"
 
@@ -30,12 +33,33 @@ void ArrayAccess::analyse(SemanticAnalyser* analyser, const Type) {
 	key->analyse(analyser);
 	constant = array->constant and key->constant;
 
-	if (array->type.raw_type == RawType::ARRAY and array->type.homogeneous) {
+	element = -1;
+	VariableValue* vv = dynamic_cast<VariableValue*>(array);
+	Array* literal = vv != nullptr ? dynamic_cast<Array*>(vv->var->value) : nullptr;
+	const Number* index = dynamic_cast<const Number*>(key->literal());
+	if (literal != nullptr and key2 == nullptr and index != nullptr and index->value == (int) index->value
+		and index->value >= 0 and index->value < literal->expressions.size()) {
+		element = index->value;
+		vv->var->element_uses++;
+		analyser->element_reads.push_back({vv->var, &scalar});
+	}
+
+	if (element != -1 and scalar) {
+		type = literal->expressions[element]->type;
+	} else if (array->type.raw_type == RawType::ARRAY and array->type.homogeneous) {
 		type = array->type.getElementType();
 		type.nature = Nature::POINTER;
 	}
 }
 
+void ArrayAccess::fold() {
+	array->fold();
+	key->fold();
+	if (key2 != nullptr) {
+		key2->fold();
+	}
+}
+
 bool ArrayAccess::will_take(SemanticAnalyser* analyser, const unsigned pos, const Type arg_type) {
 
 	type.will_take(pos, arg_type);
@@ -64,23 +88,57 @@ bool ArrayAccess::array_access_will_take(SemanticAnalyser* analyser, const unsig
 	return false;
 }
 
+/*
+ * Release the temporary container of an accessed value,
+ * the value being kept alive if it belongs to it
+ */
+LSValue* release_container(LSValue* container, LSValue* res) {
+	LSValue::inc_refs(res);
+	LSValue::delete_temporary(container);
+	LSValue::dec_refs(res);
+	return res;
+}
+
 LSValue* access_temp(LSArray* array, LSValue* key) {
-	return array->at(key);
+	LSValue* res = array->at(key);
+	if (key != res) LSValue::delete_temporary(key);
+	return release_container(array, res);
+}
+
+/*
+ * Value of an array changed in place by the caller : the array is boxed
+ */
+LSValue* access_in_place(LSArray* array, LSValue* key) {
+	if (array->typeID() != 5) {
+		return access_temp(array, key);
+	}
+	LSValue* res = *array->atL(key);
+	if (key != res) LSValue::delete_temporary(key);
+	return release_container(array, res);
 }
 
 LSValue** access_l(LSArray* array, LSValue* key) {
-	return array->atL(key);
+	LSValue** res = array->atL(key);
+	LSValue::delete_temporary(key);
+	return res;
 }
 
 LSValue* range(LSArray* array, LSValue* start, LSValue* end) {
-	return array->range(start, end);
+	LSValue* res = array->range(start, end);
+	LSValue::delete_temporary(start);
+	LSValue::delete_temporary(end);
+	return release_container(array, res);
 }
 
 //LSValue* access_int(LSArray* array, int key) {
 //	return array->at(key);
 //}
 
-jit_value_t ArrayAccess::compile_jit(Compiler& c, jit_function_t& F, Type) const {
+jit_value_t ArrayAccess::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
+
+	if (element != -1 and ((VariableValue*) array)->var->scalar_replaced()) {
+		return ((VariableValue*) array)->compile_element(c, F, element, scalar ? req_type : Type::POINTER);
+	}
 
 	jit_value_t a = array->compile_jit(c, F, Type::POINTER);
 
@@ -91,7 +149,8 @@ jit_value_t ArrayAccess::compile_jit(Compiler& c, jit_function_t& F, Type) const
 
 		jit_value_t k = key->compile_jit(c, F, Type::POINTER);
 		jit_value_t args[] = {a, k};
-		return jit_insn_call_native(F, "access", (void*) access_temp, sig, args, 2, JIT_CALL_NOTHROW);
+		void* access = in_place ? (void*) access_in_place : (void*) access_temp;
+		return jit_insn_call_native(F, "access", access, sig, args, 2, JIT_CALL_NOTHROW);
 
 	} else {
 
@@ -10,6 +10,12 @@ public:
 	Value* array;
 	Value* key;
 	Value* key2;
+	// Index of the element read in the literal array of a variable, -1 otherwise
+	int element = -1;
+	// The element is scalar replaced : the access is typed as its value
+	bool scalar = false;
+	// The value is changed in place (a[0] += 1) : it's accessed by reference
+	bool in_place = false;
 
 	ArrayAccess();
 	virtual ~ArrayAccess();
@@ -17,6 +23,7 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 
 	virtual bool will_take(SemanticAnalyser* analyser, const unsigned, const Type);
 
@@ -21,7 +21,7 @@ void Boolean::analyse(SemanticAnalyser*, const Type) {}
 jit_value_t Boolean::compile_jit(Compiler&, jit_function_t& F, Type req_type) const {
 
 	if (req_type.nature == Nature::POINTER) {
-		LSBoolean* b = new LSBoolean(value);
+		LSBoolean* b = make_native(new LSBoolean(value));
 		return JIT_CREATE_CONST_POINTER(F, b);
 	} else {
 		return JIT_CREATE_CONST(F, JIT_INTEGER, value);
@@ -4,6 +4,14 @@
 #include "LeftValue.hpp"
 #include "Number.hpp"
 #include "Function.hpp"
+#include "FusedLoop.hpp"
+#include "../instruction/LoopMotion.hpp"
+#include "Boolean.hpp"
+#include "String.hpp"
+#include "../../vm/standard/ArrayKernels.hpp"
+#include "../semantic/SemanticError.hpp"
+#include <math.h>
+#include <climits>
 
 using namespace std;
 
@@ -11,6 +19,7 @@ Expression::Expression() {
 	v1 = nullptr;
 	v2 = nullptr;
 	op = nullptr;
+	op_type = TokenType::UNKNOW;
 	fast = false;
 	ignorev2 = false;
 	no_op = false;
@@ -20,6 +29,7 @@ Expression::Expression(Value* v) {
 	v1 = v;
 	v2 = nullptr;
 	op = nullptr;
+	op_type = TokenType::UNKNOW;
 	fast = false;
 	ignorev2 = false;
 	no_op = false;
@@ -85,6 +95,37 @@ void Expression::print(ostream& os) const {
 	os <<  "}";
 }
 
+static bool is_assignment(TokenType op) {
+	switch (op) {
+		case TokenType::EQUAL: case TokenType::PLUS_EQUAL: case TokenType::MINUS_EQUAL:
+		case TokenType::TIMES_EQUAL: case TokenType::DIVIDE_EQUAL: case TokenType::MODULO_EQUAL:
+		case TokenType::POWER_EQUAL: case TokenType::TILDE_EQUAL: case TokenType::TILDE_TILDE_EQUAL:
+		case TokenType::TILDE_PLUS_EQUAL: case TokenType::TILDE_MINUS_EQUAL: case TokenType::TILDE_TIMES_EQUAL:
+		case TokenType::TILDE_DIVIDE_EQUAL: case TokenType::SWAP:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Element-wise operators (~+ ~- ~* ~/ and their assignments), with the
+ * operator they apply to the values
+ */
+static bool element_wise(TokenType op, TokenType& scalar_op, ArrayKernels::Operation& operation) {
+	switch (op) {
+		case TokenType::TILDE_PLUS: scalar_op = TokenType::PLUS; operation = ArrayKernels::ADD; return true;
+		case TokenType::TILDE_MINUS: scalar_op = TokenType::MINUS; operation = ArrayKernels::SUB; return true;
+		case TokenType::TILDE_TIMES: scalar_op = TokenType::TIMES; operation = ArrayKernels::MUL; return true;
+		case TokenType::TILDE_DIVIDE: scalar_op = TokenType::DIVIDE; operation = ArrayKernels::DIV; return true;
+		case TokenType::TILDE_PLUS_EQUAL: scalar_op = TokenType::PLUS_EQUAL; operation = ArrayKernels::ADD; return true;
+		case TokenType::TILDE_MINUS_EQUAL: scalar_op = TokenType::MINUS_EQUAL; operation = ArrayKernels::SUB; return true;
+		case TokenType::TILDE_TIMES_EQUAL: scalar_op = TokenType::TIMES_EQUAL; operation = ArrayKernels::MUL; return true;
+		case TokenType::TILDE_DIVIDE_EQUAL: scalar_op = TokenType::DIVIDE_EQUAL; operation = ArrayKernels::DIV; return true;
+		default: return false;
+	}
+}
+
 void Expression::analyse(SemanticAnalyser* analyser, const Type) {
 
 	type = Type::VALUE;
@@ -94,7 +135,8 @@ void Expression::analyse(SemanticAnalyser* analyser, const Type) {
 	Type v2_type = Type::NEUTRAL;
 
 	if (op != nullptr) {
-		if (op->type == TokenType::DIVIDE) {
+		op_type = op->type;
+		if (op_type == TokenType::DIVIDE) {
 			type.raw_type = RawType::FLOAT;
 			v1_type = Type::FLOAT;
 			v2_type = Type::FLOAT;
@@ -115,13 +157,49 @@ void Expression::analyse(SemanticAnalyser* analyser, const Type) {
 
 	if (v1 != nullptr and v2 != nullptr) {
 
-		if (op->type == TokenType::EQUAL or op->type == TokenType::PLUS
-			or op->type == TokenType::TIMES or op->type == TokenType::MINUS) {
+		SemanticVar* assigned = SemanticAnalyser::assigned_var(v1);
+		if (assigned != nullptr and is_assignment(op_type)) {
+			assigned->assignments++;
+		}
+		if (is_assignment(op_type) and op_type != TokenType::EQUAL and op_type != TokenType::SWAP) {
+			SemanticAnalyser::changed_in_place(v1);
+		}
+		SemanticVar* swapped = SemanticAnalyser::assigned_var(v2);
+		if (swapped != nullptr and op_type == TokenType::SWAP) {
+			swapped->assignments++;
+		}
+
+		/*
+		 * Element-wise operations on numbers are the operations themselves,
+		 * the division excepted : its operands weren't analysed as floats.
+		 * The operator is kept : a function analysed again with other types
+		 * of arguments can get arrays.
+		 */
+		TokenType scalar_op;
+		ArrayKernels::Operation operation;
+		if (element_wise(op_type, scalar_op, operation)) {
+			// A variable holding a number can't receive the array of the operation
+			if (v1->type.nature == Nature::VALUE and is_assignment(op_type) and v2->type.nature != Nature::VALUE) {
+				throw SemanticError(op->token, "Operator « " + op->character + " » needs an array on its left!");
+			}
+			if (v1->type.nature == Nature::VALUE and (is_assignment(op_type)
+				or (v2->type.nature == Nature::VALUE and op_type != TokenType::TILDE_DIVIDE))) {
+				op_type = scalar_op;
+			} else if (v1->type.raw_type == RawType::ARRAY or (!is_assignment(op_type)
+				and v2->type.raw_type == RawType::ARRAY)) {
+				type = Type::ARRAY;
+			} else {
+				type = Type::POINTER;
+			}
+		}
+
+		if (op_type == TokenType::EQUAL or op_type == TokenType::PLUS
+			or op_type == TokenType::TIMES or op_type == TokenType::MINUS) {
 
 			type = v1->type.mix(v2->type);
 		}
 
-		if (op->type == TokenType::TILDE_TILDE) {
+		if (op_type == TokenType::TILDE_TILDE) {
 
 			v2->will_take(analyser, 0, Type::POINTER);
 
@@ -136,71 +214,166 @@ void Expression::analyse(SemanticAnalyser* analyser, const Type) {
 	}
 }
 
+/*
+ * Operations on literals are computed once, before the compilation
+ */
+void Expression::fold() {
+
+	if (v1 != nullptr) v1->fold();
+	if (v2 != nullptr) v2->fold();
+
+	if (op == nullptr or v1 == nullptr or v2 == nullptr) {
+		return;
+	}
+	const Value* l1 = v1->literal();
+	const Value* l2 = v2->literal();
+	if (l1 == nullptr or l2 == nullptr) {
+		return;
+	}
+
+	const String* s1 = dynamic_cast<const String*>(l1);
+	const String* s2 = dynamic_cast<const String*>(l2);
+	if (s1 != nullptr and s2 != nullptr and op_type == TokenType::PLUS) {
+		folded = new String(s1->value + s2->value);
+		return;
+	}
+
+	const Number* n1 = dynamic_cast<const Number*>(l1);
+	const Number* n2 = dynamic_cast<const Number*>(l2);
+	if (n1 == nullptr or n2 == nullptr or type.nature != Nature::VALUE) {
+		return;
+	}
+	double a = n1->value;
+	double b = n2->value;
+	bool floating = n1->type.raw_type == RawType::FLOAT or n2->type.raw_type == RawType::FLOAT;
+	double r;
+
+	switch (op_type) {
+		case TokenType::PLUS: r = a + b; break;
+		case TokenType::MINUS: r = a - b; break;
+		case TokenType::TIMES: r = a * b; break;
+		case TokenType::DIVIDE: {
+			if (b == 0) return;
+			r = a / b;
+			floating = true;
+			break;
+		}
+		case TokenType::MODULO: {
+			if (b == 0) return;
+			r = fmod(a, b);
+			break;
+		}
+		case TokenType::POWER: {
+			if (!floating and b < 0) return;
+			r = pow(a, b);
+			break;
+		}
+		case TokenType::DOUBLE_EQUAL: folded = new Boolean(a == b); return;
+		case TokenType::DIFFERENT: folded = new Boolean(a != b); return;
+		case TokenType::LOWER: folded = new Boolean(a < b); return;
+		case TokenType::LOWER_EQUALS: folded = new Boolean(a <= b); return;
+		case TokenType::GREATER: folded = new Boolean(a > b); return;
+		case TokenType::GREATER_EQUALS: folded = new Boolean(a >= b); return;
+		default: return;
+	}
+	if (type.raw_type == RawType::FLOAT or type.raw_type == RawType::INTEGER) {
+		floating = type.raw_type == RawType::FLOAT;
+	}
+	folded = Number::computed(r, floating);
+}
+
+const Value* Expression::literal() const {
+	if (op == nullptr) {
+		return v1->literal();
+	}
+	return Value::literal();
+}
+
+/*
+ * Delete the temporary operands of an operation, keeping the result
+ * even if it's one of them
+ */
+inline LSValue* jit_result(LSValue* res, LSValue* x, LSValue* y) {
+	LSValue::inc_refs(res);
+	LSValue::delete_temporary(x);
+	if (y != x) {
+		LSValue::delete_temporary(y);
+	}
+	LSValue::dec_refs(res);
+	return res;
+}
+
 LSValue* jit_not(LSValue* x) {
-	return x->operator ! ();
+	return jit_result(x->operator ! (), x, x);
 }
 LSValue* jit_minus(LSValue* x) {
-	return x->operator - ();
+	return jit_result(x->operator - (), x, x);
 }
 LSValue* jit_add(LSValue* x, LSValue* y) {
-	return y->operator + (x);
+	return jit_result(y->operator + (x), x, y);
 }
 LSValue* jit_sub(LSValue* x, LSValue* y) {
-	return y->operator - (x);
+	return jit_result(y->operator - (x), x, y);
 }
 LSValue* jit_mul(LSValue* x, LSValue* y) {
-	return y->operator * (x);
+	return jit_result(y->operator * (x), x, y);
 }
 LSValue* jit_div(LSValue* x, LSValue* y) {
-	return y->operator / (x);
+	return jit_result(y->operator / (x), x, y);
 }
 LSValue* jit_pow(LSValue* x, LSValue* y) {
-	return y->poww(x);
+	return jit_result(y->poww(x), x, y);
 }
 LSValue* jit_mod(LSValue* x, LSValue* y) {
-	return y->operator % (x);
+	return jit_result(y->operator % (x), x, y);
 }
 LSValue* jit_and(LSValue* x, LSValue* y) {
-	return LSBoolean::get(x->isTrue() and y->isTrue());
+	return jit_result(LSBoolean::get(x->isTrue() and y->isTrue()), x, y);
 }
 LSValue* jit_or(LSValue* x, LSValue* y) {
-	return LSBoolean::get(x->isTrue() or y->isTrue());
+	return jit_result(LSBoolean::get(x->isTrue() or y->isTrue()), x, y);
 }
 LSValue* jit_inc(LSValue* x) {
-	return x->operator ++ (1);
+	return jit_result(x->operator ++ (1), x, x);
 }
 LSValue* jit_dec(LSValue* x) {
-	return x->operator -- (1);
+	return jit_result(x->operator -- (1), x, x);
 }
 LSValue* jit_pre_inc(LSValue* x) {
-	return x->operator ++ ();
+	return jit_result(x->operator ++ (), x, x);
 }
 LSValue* jit_pre_dec(LSValue* x) {
-	return x->operator -- ();
+	return jit_result(x->operator -- (), x, x);
 }
 
 LSValue* jit_equals(LSValue* x, LSValue* y) {
-	return LSBoolean::get(x->operator == (y));
+	return jit_result(LSBoolean::get(x->operator == (y)), x, y);
 }
 LSValue* jit_not_equals(LSValue* x, LSValue* y) {
-	return LSBoolean::get(x->operator != (y));
+	return jit_result(LSBoolean::get(x->operator != (y)), x, y);
 }
 LSValue* jit_lt(LSValue* x, LSValue* y) {
-	return LSBoolean::get(y->operator < (x));
+	return jit_result(LSBoolean::get(y->operator < (x)), x, y);
 }
 LSValue* jit_le(LSValue* x, LSValue* y) {
-	return LSBoolean::get(y->operator <= (x));
+	return jit_result(LSBoolean::get(y->operator <= (x)), x, y);
 }
 LSValue* jit_gt(LSValue* x, LSValue* y) {
-	return LSBoolean::get(y->operator > (x));
+	return jit_result(LSBoolean::get(y->operator > (x)), x, y);
 }
 LSValue* jit_ge(LSValue* x, LSValue* y) {
-	return LSBoolean::get(y->operator >= (x));
+	return jit_result(LSBoolean::get(y->operator >= (x)), x, y);
 }
 
 LSValue* jit_store(LSValue** x, LSValue* y) {
-//	cout << "store" << endl;
-	return *x = y;
+	// Unknown element : nothing to store in
+	if (x == &LSNull::null_var) {
+		return y;
+	}
+	LSValue* old = *x;
+	*x = y->move_inc();
+	LSValue::delete_ref(old);
+	return *x;
 }
 
 LSValue* jit_swap(LSValue** x, LSValue** y) {
@@ -211,22 +384,22 @@ LSValue* jit_swap(LSValue** x, LSValue** y) {
 }
 
 LSValue* jit_add_equal(LSValue* x, LSValue* y) {
-	return y->operator += (x);
+	return jit_result(y->operator += (x), x, y);
 }
 LSValue* jit_sub_equal(LSValue* x, LSValue* y) {
-	return y->operator -= (x);
+	return jit_result(y->operator -= (x), x, y);
 }
 LSValue* jit_mul_equal(LSValue* x, LSValue* y) {
-	return y->operator *= (x);
+	return jit_result(y->operator *= (x), x, y);
 }
 LSValue* jit_div_equal(LSValue* x, LSValue* y) {
-	return y->operator /= (x);
+	return jit_result(y->operator /= (x), x, y);
 }
 LSValue* jit_mod_equal(LSValue* x, LSValue* y) {
-	return y->operator %= (x);
+	return jit_result(y->operator %= (x), x, y);
 }
 LSValue* jit_pow_equal(LSValue* x, LSValue* y) {
-	return y->pow_eq(x);
+	return jit_result(y->pow_eq(x), x, y);
 }
 
 LSArray* jit_tilde_tilde(LSArray* array, LSFunction* fun) {
@@ -236,9 +409,10 @@ LSArray* jit_tilde_tilde(LSArray* array, LSFunction* fun) {
 	typedef int (*FF)(LSValue*);
 	FF f = (FF) fun->function;
 
-	for (auto key : array->values) {
-		new_array->pushClone(LSNumber::get(f(key.second)));
+	for (LSValue* v : *array) {
+		new_array->pushNoClone(new LSNumber(f(v)));
 	}
+	LSValue::delete_temporary(array);
 	return new_array;
 }
 
@@ -249,14 +423,416 @@ LSArray* jit_tilde_tilde_pointer(LSArray* array, LSFunction* fun) {
 	typedef LSValue* (*FF)(LSValue*);
 	FF f = (FF) fun->function;
 
-	for (auto key : array->values) {
-		new_array->pushClone(f(key.second));
+	for (LSValue* v : *array) {
+		new_array->pushMove(f(v));
 	}
+	LSValue::delete_temporary(array);
 	return new_array;
 }
 
+/*
+ * Element-wise operations : between two arrays, the values at the same
+ * positions, up to the end of the shortest one, and between an array and
+ * another value, each value of the array with it. The unboxed arrays and the
+ * numbers are computed on their raw values by the ArrayKernels, the result
+ * being unboxed, the other arrays value by value.
+ */
+struct RawOperand {
+	RawType type;
+	bool scalar;
+	const int* ints;
+	const double* reals;
+	int int_value;
+	double real_value;
+	size_t size;
+};
+
+static RawOperand raw_number(double value) {
+	RawOperand number;
+	number.scalar = true;
+	number.ints = nullptr;
+	number.reals = nullptr;
+	number.size = SIZE_MAX;
+	number.real_value = value;
+	number.int_value = 0;
+	if (value >= INT_MIN and value <= INT_MAX and value == (int) value) {
+		number.type = RawType::INTEGER;
+		number.int_value = value;
+	} else {
+		number.type = RawType::FLOAT;
+	}
+	return number;
+}
+
+static bool raw_operand(const LSValue* value, RawOperand& operand) {
+	if (value->typeID() == 3) {
+		operand = raw_number(((const LSNumber*) value)->value);
+		return true;
+	}
+	const LSArray* array = (const LSArray*) value;
+	if (value->typeID() != 5 or array->unboxed == RawType::UNKNOWN) {
+		return false;
+	}
+	operand.type = array->unboxed;
+	operand.scalar = false;
+	operand.ints = array->ints.data();
+	operand.reals = array->reals.data();
+	operand.size = array->size();
+	return true;
+}
+
+/*
+ * Stores a op b in the raw values of the result, which can be the array of a
+ */
+static void compute_raw(ArrayKernels::Operation op, LSArray* result, const RawOperand& a, const RawOperand& b) {
+
+	const ArrayKernels& kernels = ArrayKernels::get();
+	size_t size = min(a.size, b.size);
+
+	if (a.type == RawType::INTEGER and b.type == RawType::INTEGER and op != ArrayKernels::DIV) {
+		result->ints.resize(size);
+		int* r = result->ints.data();
+		if (a.scalar) {
+			kernels.fill_ints(r, size, a.int_value);
+			kernels.zip_ints(op, r, r, b.ints, size);
+		} else if (b.scalar) {
+			kernels.map_ints(op, r, a.ints, b.int_value, size);
+		} else {
+			kernels.zip_ints(op, r, a.ints, b.ints, size);
+		}
+		result->unboxed = RawType::INTEGER;
+
+	} else {
+		result->reals.resize(size);
+		double* r = result->reals.data();
+		const double* first = a.reals;
+		if (a.scalar) {
+			kernels.fill_reals(r, size, a.real_value);
+			first = r;
+		} else if (a.type == RawType::INTEGER) {
+			kernels.to_reals(r, a.ints, size);
+			first = r;
+		}
+		if (b.scalar) {
+			kernels.map_reals(op, r, first, b.real_value, size);
+		} else if (b.type == RawType::FLOAT) {
+			kernels.zip_reals(op, r, first, b.reals, size);
+		} else {
+			// Integers converted by blocks, without a copy of the array
+			double block[256];
+			for (size_t i = 0; i < size; i += 256) {
+				size_t count = min((size_t) 256, size - i);
+				kernels.to_reals(block, b.ints + i, count);
+				kernels.zip_reals(op, r + i, first + i, block, count);
+			}
+		}
+		if (result->unboxed == RawType::INTEGER) {
+			decltype(result->ints)().swap(result->ints);
+		}
+		result->unboxed = RawType::FLOAT;
+	}
+	result->index = size;
+}
+
+static LSValue* apply(ArrayKernels::Operation op, LSValue* x, LSValue* y) {
+	switch (op) {
+		case ArrayKernels::ADD: return y->operator + (x);
+		case ArrayKernels::SUB: return y->operator - (x);
+		case ArrayKernels::MUL: return y->operator * (x);
+		default: return y->operator / (x);
+	}
+}
+
+// The result keeps the keys of an associative array
+static void push_result(LSArray* result, const LSArrayIterator& it, LSValue* value) {
+	if (it.key() != nullptr) {
+		result->pushKeyNoClone(it.key()->clone(), value->move());
+	} else {
+		result->pushMove(value);
+	}
+}
+
+static LSValue* compute_values(ArrayKernels::Operation op, LSValue* x, LSValue* y) {
+
+	LSArray* xs = x->typeID() == 5 ? (LSArray*) x : nullptr;
+	LSArray* ys = y->typeID() == 5 ? (LSArray*) y : nullptr;
+	if (xs == nullptr and ys == nullptr) {
+		return apply(op, x, y);
+	}
+	LSArray* result = new LSArray();
+	if (xs != nullptr and ys != nullptr) {
+		LSArrayIterator i = xs->begin();
+		LSArrayIterator j = ys->begin();
+		for (; !i.at_end() and !j.at_end(); ++i, ++j) {
+			push_result(result, i, apply(op, *i, *j));
+		}
+	} else if (xs != nullptr) {
+		for (LSArrayIterator i = xs->begin(); !i.at_end(); ++i) {
+			push_result(result, i, apply(op, *i, y));
+		}
+	} else {
+		for (LSArrayIterator i = ys->begin(); !i.at_end(); ++i) {
+			push_result(result, i, apply(op, x, *i));
+		}
+	}
+	return result;
+}
+
+LSValue* jit_element_wise(LSValue* x, LSValue* y, int op) {
+	RawOperand a, b;
+	if (raw_operand(x, a) and raw_operand(y, b) and !(a.scalar and b.scalar)) {
+		LSArray* result = new LSArray();
+		compute_raw((ArrayKernels::Operation) op, result, a, b);
+		return jit_result(result, x, y);
+	}
+	return jit_result(compute_values((ArrayKernels::Operation) op, x, y), x, y);
+}
+
+LSValue* jit_element_wise_real(LSValue* x, double y, int op) {
+	RawOperand a;
+	if (raw_operand(x, a) and !a.scalar) {
+		LSArray* result = new LSArray();
+		compute_raw((ArrayKernels::Operation) op, result, a, raw_number(y));
+		return jit_result(result, x, x);
+	}
+	return jit_element_wise(x, LSNumber::get(y), op);
+}
+
+LSValue* jit_element_wise_int(LSValue* x, int y, int op) {
+	return jit_element_wise_real(x, y, op);
+}
+
+/*
+ * The array is modified in place, the other values get the operation itself
+ */
+LSValue* jit_element_wise_equal(LSValue* x, LSValue* y, int op) {
+
+	if (x->typeID() != 5) {
+		switch (op) {
+			case ArrayKernels::ADD: return jit_add_equal(x, y);
+			case ArrayKernels::SUB: return jit_sub_equal(x, y);
+			case ArrayKernels::MUL: return jit_mul_equal(x, y);
+			default: return jit_div_equal(x, y);
+		}
+	}
+	LSArray* array = (LSArray*) x;
+	RawOperand a, b;
+	if (raw_operand(x, a) and raw_operand(y, b)) {
+		compute_raw((ArrayKernels::Operation) op, array, a, b);
+	} else {
+		LSArray* result = (LSArray*) compute_values((ArrayKernels::Operation) op, x, y);
+		array->clear();
+		array->list.swap(result->list);
+		array->entries.swap(result->entries);
+		array->associative = result->associative;
+		array->index = result->index;
+		delete result;
+	}
+	return jit_result(x, x, y);
+}
+
+LSValue* jit_element_wise_equal_real(LSValue* x, double y, int op) {
+	RawOperand a;
+	if (raw_operand(x, a) and !a.scalar) {
+		compute_raw((ArrayKernels::Operation) op, (LSArray*) x, a, raw_number(y));
+		return x;
+	}
+	return jit_element_wise_equal(x, LSNumber::get(y), op);
+}
+
+LSValue* jit_element_wise_equal_int(LSValue* x, int y, int op) {
+	return jit_element_wise_equal_real(x, y, op);
+}
+
 LSValue* jit_in(LSValue* x, LSValue* y) {
-	return LSBoolean::get(y->in(x));
+	return jit_result(LSBoolean::get(y->in(x)), x, y);
+}
+
+LSValue* jit_number(double value) {
+	return LSNumber::get(value);
+}
+LSValue* jit_add_strings(LSString* x, LSString* y) {
+	return jit_result(new LSString(x->value + y->value), x, y);
+}
+
+/*
+ * Layout of the values, read inline by the fast paths of the operators :
+ * a value is identified by its virtual table
+ */
+static const LSNumber number_model;
+static const LSString string_model;
+
+static void* class_tag(const LSValue& model) {
+	return *(void**) &model;
+}
+static jit_nint offset_in(const LSValue& model, const void* field) {
+	return (const char*) field - (const char*) &model;
+}
+
+/*
+ * Release an operand of the inline path, the call being only made
+ * for a real temporary
+ */
+static void release_operand(jit_function_t& F, jit_value_t& v) {
+
+	jit_label_t label_kept = jit_label_undefined;
+
+	jit_value_t refs = jit_insn_load_relative(F, v, offset_in(number_model, &number_model.refs), JIT_INTEGER);
+	jit_insn_branch_if(F, refs, &label_kept);
+	jit_value_t native = jit_insn_load_relative(F, v, offset_in(number_model, &number_model.native), jit_type_ubyte);
+	jit_insn_branch_if(F, native, &label_kept);
+	VM::delete_temporary(F, v);
+
+	jit_insn_label(F, &label_kept);
+}
+
+/*
+ * The operations on numbers, and the concatenation of strings, are inlined
+ * when an operand is a pointer : the numbers are computed directly after a
+ * check of their types, the other values going through the generic function
+ */
+bool Expression::has_inline_path() const {
+
+	switch (op_type) {
+		case TokenType::PLUS: case TokenType::MINUS: case TokenType::TIMES: case TokenType::DIVIDE:
+		case TokenType::LOWER: case TokenType::LOWER_EQUALS: case TokenType::GREATER: case TokenType::GREATER_EQUALS:
+		case TokenType::DOUBLE_EQUAL: case TokenType::DIFFERENT:
+			break;
+		default:
+			return false;
+	}
+	for (Value* v : {v1, v2}) {
+		if (v->type.nature != Nature::POINTER and (v->type.nature != Nature::VALUE
+			or (v->type.raw_type != RawType::INTEGER and v->type.raw_type != RawType::FLOAT))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+jit_value_t Expression::compile_jit_inline(Compiler& c, jit_function_t& F, void* ls_func) const {
+
+	jit_label_t label_not_numbers = jit_label_undefined;
+	jit_label_t label_generic = jit_label_undefined;
+	jit_label_t label_end = jit_label_undefined;
+
+	bool x_pointer = v1->type.nature == Nature::POINTER;
+	bool y_pointer = v2->type.nature == Nature::POINTER;
+	jit_value_t x = v1->compile_jit(c, F, x_pointer ? Type::POINTER : Type::NEUTRAL);
+	jit_value_t y = v2->compile_jit(c, F, y_pointer ? Type::POINTER : Type::NEUTRAL);
+
+	jit_value_t res = jit_value_create(F, JIT_POINTER);
+	jit_value_t number = JIT_CREATE_CONST_POINTER(F, class_tag(number_model));
+	jit_nint value_offset = offset_in(number_model, &number_model.value);
+
+	// Values of the numbers, checking the pointers
+	jit_value_t a, b;
+	if (x_pointer) {
+		jit_insn_branch_if_not(F, jit_insn_eq(F, jit_insn_load_relative(F, x, 0, JIT_POINTER), number), &label_not_numbers);
+		a = jit_insn_load_relative(F, x, value_offset, JIT_FLOAT);
+	} else {
+		a = jit_insn_convert(F, x, JIT_FLOAT, 0);
+	}
+	if (y_pointer) {
+		jit_insn_branch_if_not(F, jit_insn_eq(F, jit_insn_load_relative(F, y, 0, JIT_POINTER), number), &label_generic);
+		b = jit_insn_load_relative(F, y, value_offset, JIT_FLOAT);
+	} else {
+		b = jit_insn_convert(F, y, JIT_FLOAT, 0);
+	}
+
+	jit_value_t r = nullptr;
+	jit_value_t (*compare)(jit_function_t, jit_value_t, jit_value_t) = nullptr;
+	switch (op_type) {
+		case TokenType::PLUS: r = jit_insn_add(F, a, b); break;
+		case TokenType::MINUS: r = jit_insn_sub(F, a, b); break;
+		case TokenType::TIMES: r = jit_insn_mul(F, a, b); break;
+		case TokenType::DIVIDE: r = jit_insn_div(F, a, b); break;
+		case TokenType::LOWER: compare = &jit_insn_lt; break;
+		case TokenType::LOWER_EQUALS: compare = &jit_insn_le; break;
+		case TokenType::GREATER: compare = &jit_insn_gt; break;
+		case TokenType::GREATER_EQUALS: compare = &jit_insn_ge; break;
+		case TokenType::DOUBLE_EQUAL: compare = &jit_insn_eq; break;
+		default: compare = &jit_insn_ne; break;
+	}
+	if (r != nullptr) {
+		jit_type_t args_types[1] = {JIT_FLOAT};
+		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
+		jit_insn_store(F, res, jit_insn_call_native(F, "number", (void*) jit_number, sig, &r, 1, JIT_CALL_NOTHROW));
+	} else {
+		jit_label_t label_false = jit_label_undefined;
+		jit_insn_store(F, res, JIT_CREATE_CONST_POINTER(F, LSBoolean::false_val));
+		jit_insn_branch_if_not(F, compare(F, a, b), &label_false);
+		jit_insn_store(F, res, JIT_CREATE_CONST_POINTER(F, LSBoolean::true_val));
+		jit_insn_label(F, &label_false);
+	}
+	if (x_pointer) release_operand(F, x);
+	if (y_pointer) release_operand(F, y);
+	jit_insn_branch(F, &label_end);
+
+	jit_insn_label(F, &label_not_numbers);
+
+	jit_type_t args_types[2] = {JIT_POINTER, JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 2, 0);
+
+	// Concatenation of two strings
+	if (op_type == TokenType::PLUS and x_pointer and y_pointer) {
+		jit_value_t string = JIT_CREATE_CONST_POINTER(F, class_tag(string_model));
+		jit_insn_branch_if_not(F, jit_insn_eq(F, jit_insn_load_relative(F, x, 0, JIT_POINTER), string), &label_generic);
+		jit_insn_branch_if_not(F, jit_insn_eq(F, jit_insn_load_relative(F, y, 0, JIT_POINTER), string), &label_generic);
+		jit_value_t args[] = {x, y};
+		jit_insn_store(F, res, jit_insn_call_native(F, "add", (void*) jit_add_strings, sig, args, 2, JIT_CALL_NOTHROW));
+		jit_insn_branch(F, &label_end);
+	}
+
+	// Any other values
+	jit_insn_label(F, &label_generic);
+	jit_value_t args[] = {
+		x_pointer ? x : VM::value_to_pointer(F, x, v1->type),
+		y_pointer ? y : VM::value_to_pointer(F, y, v2->type)
+	};
+	jit_insn_store(F, res, jit_insn_call_native(F, "", ls_func, sig, args, 2, JIT_CALL_NOTHROW));
+
+	jit_insn_label(F, &label_end);
+
+	return res;
+}
+
+/*
+ * A number operand on the right is given unboxed : the loop over the raw
+ * values of the array allocates nothing else than the result
+ */
+jit_value_t Expression::compile_element_wise(Compiler& c, jit_function_t& F, int operation) const {
+
+	bool assignment = is_assignment(op_type);
+
+	bool x_pointer = v1->type.nature == Nature::POINTER;
+	jit_value_t x = v1->compile_jit(c, F, x_pointer ? Type::POINTER : Type::NEUTRAL);
+	if (!x_pointer) {
+		x = VM::value_to_pointer(F, x, v1->type);
+	}
+
+	jit_value_t y;
+	jit_type_t y_type;
+	void* function;
+	if (v2->type.nature == Nature::VALUE and (v2->type.raw_type == RawType::INTEGER or v2->type.raw_type == RawType::FLOAT)) {
+		bool real = v2->type.raw_type == RawType::FLOAT;
+		y = v2->compile_jit(c, F, Type::NEUTRAL);
+		y_type = real ? JIT_FLOAT : JIT_INTEGER;
+		if (assignment) {
+			function = real ? (void*) jit_element_wise_equal_real : (void*) jit_element_wise_equal_int;
+		} else {
+			function = real ? (void*) jit_element_wise_real : (void*) jit_element_wise_int;
+		}
+	} else {
+		y = v2->compile_jit(c, F, Type::POINTER);
+		y_type = JIT_POINTER;
+		function = assignment ? (void*) jit_element_wise_equal : (void*) jit_element_wise;
+	}
+
+	jit_type_t args_types[3] = {JIT_POINTER, y_type, JIT_INTEGER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 3, 0);
+	jit_value_t args[] = {x, y, JIT_CREATE_CONST(F, JIT_INTEGER, operation)};
+	return jit_insn_call_native(F, "element_wise", function, sig, args, 3, JIT_CALL_NOTHROW);
 }
 
 jit_value_t Expression::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
@@ -264,6 +840,27 @@ jit_value_t Expression::compile_jit(Compiler& c, jit_function_t& F, Type req_typ
 	if (op == nullptr) {
 		return v1->compile_jit(c, F, req_type);
 	}
+	if (folded != nullptr) {
+		return folded->compile_jit(c, F, req_type);
+	}
+	if (jit_value_t moved = LoopMotion::compile_moved(c, F, this, req_type)) {
+		return moved;
+	}
+
+	// array ~~ lambda literal : the lambda is inlined in the loop
+	if (op_type == TokenType::TILDE_TILDE and v1->type.raw_type == RawType::ARRAY) {
+		Function* lambda = dynamic_cast<Function*>(v2);
+		if (lambda != nullptr and lambda->can_inline(1)) {
+			jit_value_t array = v1->compile_jit(c, F, Type::POINTER);
+			return FusedLoop::compile(c, F, FusedLoop::Kind::MAP, array, lambda, nullptr);
+		}
+	}
+
+	TokenType scalar_op;
+	ArrayKernels::Operation operation;
+	if (element_wise(op_type, scalar_op, operation)) {
+		return compile_element_wise(c, F, operation);
+	}
 
 	jit_value_t (*jit_func)(jit_function_t, jit_value_t, jit_value_t) = nullptr;
 	void* ls_func;
@@ -273,7 +870,7 @@ jit_value_t Expression::compile_jit(Compiler& c, jit_function_t& F, Type req_typ
 	Type v1_conv = Type::POINTER;
 	Type v2_conv = Type::POINTER;
 
-	switch (op->type) {
+	switch (op_type) {
 		case TokenType::EQUAL: {
 			if (v1->type.nature == Nature::VALUE and v2->type.nature == Nature::VALUE) {
 				jit_value_t x = v1->compile_jit(c, F, Type::NEUTRAL);
@@ -287,6 +884,9 @@ jit_value_t Expression::compile_jit(Compiler& c, jit_function_t& F, Type req_typ
 				if (dynamic_cast<VariableValue*>(v1)) {
 					jit_value_t x = v1->compile_jit(c, F, Type::NEUTRAL);
 					jit_value_t y = v2->compile_jit(c, F, Type::POINTER);
+					if (c.is_function_var(x)) {
+						return VM::store_value(F, x, y);
+					}
 					jit_insn_store(F, x, y);
 					return y;
 				} else {
@@ -552,12 +1152,15 @@ jit_value_t Expression::compile_jit(Compiler& c, jit_function_t& F, Type req_typ
 		jit_type_t args_types[2] = {JIT_POINTER, JIT_POINTER};
 		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 2, 0);
 
+		if (args.size() == 0 and has_inline_path()) {
+			return compile_jit_inline(c, F, ls_func);
+		}
 		if (args.size() == 0) {
 			args.push_back(v1->compile_jit(c, F, v1_conv));
 			args.push_back(v2->compile_jit(c, F, v2_conv));
 		}
 		jit_value_t v = jit_insn_call_native(F, "", ls_func, sig, args.data(), 2, JIT_CALL_NOTHROW);
-		if (v1->type.nature == Nature::VALUE and op->type == TokenType::PLUS_EQUAL) {
+		if (v1->type.nature == Nature::VALUE and op_type == TokenType::PLUS_EQUAL) {
 			jit_insn_store(F, args[0], v);
 		}
 		return v;
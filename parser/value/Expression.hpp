@@ -11,6 +11,9 @@ public:
 	Value* v1;
 	Value* v2;
 	Operator* op;
+	// Operator applied : the one of the token, or the operator on numbers
+	// of an element-wise operator, as chosen by the last analysis
+	TokenType op_type;
 
 	bool fast;
 	bool ignorev2;
@@ -25,8 +28,13 @@ public:
 	void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
+	virtual const Value* literal() const override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
+	bool has_inline_path() const;
+	jit_value_t compile_jit_inline(Compiler&, jit_function_t&, void* ls_func) const;
+	jit_value_t compile_element_wise(Compiler&, jit_function_t&, int operation) const;
 };
 
 #endif
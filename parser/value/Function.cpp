@@ -1,6 +1,7 @@
 #include "Function.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../../vm/VM.hpp"
+#include "../instruction/Return.hpp"
 
 using namespace std;
 
@@ -69,13 +70,25 @@ void Function::analyse(SemanticAnalyser* analyser, const Type req_type) {
 	for (auto t : req_type.getArgumentTypes()) {
 		type.addArgumentType(t);
 	}
-	type.setReturnType(req_type.getReturnType());
+	// Otherwise the return type found by the previous analysis is kept for the recursive calls
+	if (req_type.getReturnType().nature != Nature::UNKNOWN) {
+		type.setReturnType(req_type.getReturnType());
+	}
 
 	analyse_body(analyser, req_type);
 
 //	cout << "Function type: " << type << endl;
 }
 
+void Function::fold() {
+	for (Value* value : defaultValues) {
+		if (value != nullptr) {
+			value->fold();
+		}
+	}
+	body->fold();
+}
+
 bool Function::will_take(SemanticAnalyser* analyser, const unsigned pos, const Type arg_type) {
 
 //	cout << "function will_take " << type << endl;
@@ -84,6 +97,13 @@ bool Function::will_take(SemanticAnalyser* analyser, const unsigned pos, const T
 
 	//cout << "function after will_take " << type << endl;
 
+	// Called from its own body : analysed again with the new types when done
+	if (analysing) {
+		recursive = true;
+		recursive_return = type.getReturnType();
+		return changed;
+	}
+
 //	if (changed) {
 		analyse_body(analyser, type);
 //	}
@@ -93,7 +113,11 @@ bool Function::will_take(SemanticAnalyser* analyser, const unsigned pos, const T
 
 void Function::analyse_body(SemanticAnalyser* analyser, const Type& req_type) {
 
+	analysing = true;
+	returns = Type::UNKNOWN;
 	analyser->enter_function(this);
+	int parent_loop_depth = analyser->loop_depth;
+	analyser->loop_depth = 0;
 
 	for (unsigned i = 0; i < arguments.size(); ++i) {
 		analyser->add_parameter(arguments[i], type.getArgumentType(i));
@@ -103,11 +127,23 @@ void Function::analyse_body(SemanticAnalyser* analyser, const Type& req_type) {
 
 	//cout << "body type: " << body->type << endl;
 
-	type.setReturnType(body->type);
+	// A recursive call as last instruction : typed by the other return statements
+	if (recursive and body->type.nature == Nature::UNKNOWN) {
+		type.setReturnType(returns);
+	} else {
+		type.setReturnType(body->type);
+	}
 
 	vars = analyser->get_local_vars();
 
+	analyser->loop_depth = parent_loop_depth;
 	analyser->leave_function();
+	analysing = false;
+
+	// The recursive calls were typed with the previous return type
+	if (recursive and type.getReturnType() != recursive_return) {
+		analyser->reanalyse = true;
+	}
 
 //	cout << "function return : " << type.getReturnType() << endl;
 }
@@ -116,8 +152,8 @@ jit_value_t Function::compile_jit(Compiler& c, jit_function_t& F, Type req_type)
 
 //	cout << "compile fun: " << type << endl;
 
-	jit_context_t context = jit_context_create();
-	jit_context_build_start(context);
+	// The functions of a program are built in its context, and destroyed with it
+	jit_context_t context = jit_function_get_context(F);
 
 	unsigned arg_count = arguments.size();
 	vector<jit_type_t> params;
@@ -142,21 +178,113 @@ jit_value_t Function::compile_jit(Compiler& c, jit_function_t& F, Type req_type)
 	jit_type_t signature = jit_type_create_signature(jit_abi_cdecl, return_type, params.data(), arg_count, 1);
 
 	jit_function_t function = jit_function_create(context, signature);
+	jit_function = function;
+
+	map<string, jit_value_t> parent_locals = c.locals;
+	std::vector<jit_value_t>* parent_inlined = c.inlined_arguments;
+	c.inlined_arguments = nullptr;
+	std::vector<LoopMotion*> parent_motions = c.loop_motions;
+	c.loop_motions.clear();
+	c.enter_function();
+
+	// The function takes a reference on its pointer arguments
+	for (unsigned i = 0; i < arg_count; ++i) {
+		if (params[i] == JIT_POINTER) {
+			jit_value_t arg = jit_value_get_param(function, i);
+			VM::take_arg(function, arg);
+			c.add_function_var(arg);
+		}
+	}
+	// Pointer local variables, released when the function returns
+	for (auto var : vars) {
+		if (var.second->scope == VarScope::LOCAL and var.second->value != nullptr
+			and var.second->type.nature == Nature::POINTER and not var.second->scalar_replaced()
+			and c.locals.find(var.first) == c.locals.end()) {
+
+			jit_value_t jit_var = jit_value_create(function, JIT_POINTER);
+			jit_insn_store(function, jit_var, jit_value_create_nint_constant(function, JIT_POINTER, 0));
+			c.locals.insert(pair<string, jit_value_t>(var.first, jit_var));
+			c.add_function_var(jit_var);
+		}
+	}
+
+	tail_label = jit_label_undefined;
+	jit_insn_label(function, &tail_label);
+	c.vm->inc_ops(function, body->operations());
 
 	jit_value_t res = body->compile_jit(c, function, type.getReturnType());
+	c.delete_function_vars(function, return_type == JIT_POINTER ? res : nullptr);
 	jit_insn_return(function, res);
 
+	c.leave_function();
+	c.inlined_arguments = parent_inlined;
+	c.loop_motions = parent_motions;
+	c.locals = parent_locals;
+
 	jit_function_compile(function);
-	jit_context_build_end(context);
 
 	void* f = jit_function_to_closure(function);
 
 	if (req_type.nature == Nature::POINTER) {
 //		cout << "create function pointer " << endl;
-		LSFunction* fo = new LSFunction(f);
+		LSFunction* fo = make_native(new LSFunction(f));
 		return JIT_CREATE_CONST_POINTER(F, fo);
 	} else {
 //		cout << "create function value " << endl;
 		return JIT_CREATE_CONST_POINTER(F, f);
 	}
 }
+
+/*
+ * A lambda (a single returned expression) taking its arguments as pointers
+ * can be compiled in the function calling it
+ */
+bool Function::can_inline(unsigned argument_count) const {
+	if (not lambda or arguments.size() > argument_count or body->instructions.size() != 1
+		or dynamic_cast<Return*>(body->instructions[0]) == nullptr
+		or type.getReturnType().raw_type == RawType::FUNCTION) {
+		return false;
+	}
+	for (unsigned i = 0; i < arguments.size(); ++i) {
+		if (i >= type.getArgumentTypes().size() or type.getArgumentType(i).nature != Nature::POINTER) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Compile the body of the lambda in F, with the same references on the
+ * arguments as a call
+ */
+jit_value_t Function::compile_inline(Compiler& c, jit_function_t& F, vector<jit_value_t> args, Type req_type) const {
+
+	map<string, jit_value_t> parent_locals = c.locals;
+	std::vector<jit_value_t>* parent_inlined = c.inlined_arguments;
+	c.enter_function();
+	c.vm->inc_ops(F, body->operations());
+
+	for (unsigned i = 0; i < arguments.size(); ++i) {
+		jit_value_t arg = jit_value_create(F, JIT_POINTER);
+		jit_insn_store(F, arg, args[i]);
+		VM::take_arg(F, arg);
+		c.add_function_var(arg);
+		args[i] = arg;
+	}
+	c.inlined_arguments = &args;
+
+	Type return_type = type.getReturnType();
+	Value* expression = ((Return*) body->instructions[0])->expression;
+	jit_value_t res = expression->compile_jit(c, F, return_type);
+	if (return_type.nature == Nature::VALUE and req_type.nature == Nature::POINTER) {
+		res = VM::value_to_pointer(F, res, return_type);
+		return_type = Type::POINTER;
+	}
+	c.delete_function_vars(F, return_type.nature == Nature::POINTER ? res : nullptr);
+
+	c.inlined_arguments = parent_inlined;
+	c.leave_function();
+	c.locals = parent_locals;
+
+	return res;
+}
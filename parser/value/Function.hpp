@@ -21,6 +21,16 @@ public:
 	int pos;
 	std::map<std::string, SemanticVar*> vars;
 	bool function_added;
+	// Being analysed, and called from its own body (with this return type)
+	bool analysing = false;
+	bool recursive = false;
+	Type recursive_return;
+	// Type of the return statements whose type is known
+	Type returns;
+	// Compiled function, in the jit context of the program, and the start of
+	// its body where self tail calls jump
+	mutable jit_function_t jit_function = nullptr;
+	mutable jit_label_t tail_label;
 
 	Function();
 	virtual ~Function();
@@ -30,12 +40,16 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 
 	bool will_take(SemanticAnalyser*, const unsigned pos, const Type) override;
 
 	void analyse_body(SemanticAnalyser*, const Type& req_type);
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
+
+	bool can_inline(unsigned argument_count) const;
+	jit_value_t compile_inline(Compiler&, jit_function_t&, std::vector<jit_value_t> args, Type req_type) const;
 };
 
 #endif
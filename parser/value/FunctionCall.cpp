@@ -3,6 +3,8 @@
 #include "VariableValue.hpp"
 #include "Function.hpp"
 #include "ObjectAccess.hpp"
+#include "FusedLoop.hpp"
+#include "Number.hpp"
 #include <math.h>
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../../vm/standard/ArraySTD.hpp"
@@ -151,6 +153,64 @@ void FunctionCall::analyse(SemanticAnalyser* analyser, const Type) {
 //	cout << "Function call function type : " << function->type << endl;
 }
 
+/*
+ * The functions of Number are pure : a call with literal arguments is
+ * computed before the compilation
+ */
+void FunctionCall::fold() {
+
+	function->fold();
+	for (Value* arg : arguments) {
+		arg->fold();
+	}
+	if (not is_native or type.nature != Nature::VALUE) {
+		return;
+	}
+	vector<double> a;
+	for (Value* arg : arguments) {
+		const Number* n = dynamic_cast<const Number*>(arg->literal());
+		if (n == nullptr) {
+			return;
+		}
+		a.push_back(n->value);
+	}
+	unsigned count = native_func == "max" or native_func == "min" or native_func == "pow" ? 2 : 1;
+	if (a.size() != count) {
+		return;
+	}
+	double r;
+	if (native_func == "abs") r = fabs(a[0]);
+	else if (native_func == "floor") r = floor(a[0]);
+	else if (native_func == "round") r = round(a[0]);
+	else if (native_func == "ceil") r = ceil(a[0]);
+	else if (native_func == "cos") r = cos(a[0]);
+	else if (native_func == "sin") r = sin(a[0]);
+	else if (native_func == "max") r = fmax(a[0], a[1]);
+	else if (native_func == "min") r = fmin(a[0], a[1]);
+	else if (native_func == "sqrt") r = sqrt(a[0]);
+	else if (native_func == "pow") r = pow(a[0], a[1]);
+	else return;
+
+	folded = Number::computed(r, type.raw_type == RawType::FLOAT);
+}
+
+/*
+ * The function called when it is known at compile time : a function literal,
+ * or a variable declared with a function and never assigned after
+ */
+Function* FunctionCall::known_function() const {
+
+	Function* literal = dynamic_cast<Function*>(function);
+	if (literal != nullptr) {
+		return literal;
+	}
+	VariableValue* vv = dynamic_cast<VariableValue*>(function);
+	if (vv != nullptr and vv->var != nullptr and vv->var->assignments == 0) {
+		return dynamic_cast<Function*>(vv->var->value);
+	}
+	return nullptr;
+}
+
 void func_print(LSValue* v) {
 	cout << " >>> ";
 	v->print(cout);
@@ -169,6 +229,10 @@ LSValue* create_int_object_3(int n) {
 
 jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
 
+	if (folded != nullptr) {
+		return folded->compile_jit(c, F, req_type);
+	}
+
 //	cout << "compile function call" << endl;
 //	cout << type << endl;
 
@@ -188,10 +252,10 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 			if (arguments.size() > 0) {
 				return arguments[0]->compile_jit(c, F, Type::POINTER);
 			}
-			return JIT_CREATE_CONST_POINTER(F, new LSString(""));
+			return JIT_CREATE_CONST_POINTER(F, make_native(new LSString("")));
 		}
 		if (vv->name->content == "Array") {
-			return JIT_CREATE_CONST_POINTER(F, new LSArray());
+			return JIT_CREATE_CONST_POINTER(F, make_native(new LSArray()));
 		}
 	}
 
@@ -248,6 +312,23 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 	 */
 	if (this_ptr != nullptr) {
 
+		// Higher order method of an array with a lambda literal : fused loop
+		ObjectAccess* oa = dynamic_cast<ObjectAccess*>(function);
+		FusedLoop::Kind kind;
+		if (oa != nullptr and this_ptr->type.raw_type == RawType::ARRAY and FusedLoop::get_kind(oa->field, kind)
+			and arguments.size() == (kind == FusedLoop::Kind::FOLD_LEFT ? 2 : 1)) {
+
+			Function* lambda = dynamic_cast<Function*>(arguments[0]);
+			if (lambda != nullptr and lambda->can_inline(FusedLoop::argument_count(kind))) {
+				jit_value_t array = this_ptr->compile_jit(c, F, Type::POINTER);
+				jit_value_t init = nullptr;
+				if (kind == FusedLoop::Kind::FOLD_LEFT) {
+					init = arguments[1]->compile_jit(c, F, Type::POINTER);
+				}
+				return FusedLoop::compile(c, F, kind, array, lambda, init);
+			}
+		}
+
 		int arg_count = arguments.size() + 1;
 		vector<jit_value_t> args = { this_ptr->compile_jit(c, F, Type::POINTER) };
 		vector<jit_type_t> args_types = { JIT_POINTER };
@@ -263,7 +344,19 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 
 		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types.data(), arg_count, 0);
 
-		return jit_insn_call_native(F, "std_func", (void*) std_func, sig, args.data(), arg_count, JIT_CALL_NOTHROW);
+		// The arguments are kept alive during the call, and released after
+		for (int i = 0; i < arg_count; ++i) {
+			if (i == 0 or function->type.getArgumentType(i).nature == Nature::POINTER) {
+				VM::inc_refs(F, args[i]);
+			}
+		}
+		jit_value_t res = jit_insn_call_native(F, "std_func", (void*) std_func, sig, args.data(), arg_count, JIT_CALL_NOTHROW);
+		for (int i = 0; i < arg_count; ++i) {
+			if (i == 0 or function->type.getArgumentType(i).nature == Nature::POINTER) {
+				VM::delete_arg(F, args[i], res);
+			}
+		}
+		return res;
 	}
 
 
@@ -280,6 +373,7 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 				jit_type_t args[1] = {JIT_POINTER};
 				jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
 				jit_insn_call_native(F, "lol", (void*) func_print, sig, &v, 1, JIT_CALL_NOTHROW);
+				VM::delete_temporary(F, v);
 			}
 
 			return JIT_CREATE_CONST_POINTER(F, LSNull::null_var);
@@ -313,11 +407,23 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 
 	vector<jit_value_t> fun;
 
-	if (function->type.nature == Nature::POINTER) {
-		jit_value_t fun_addr = function->compile_jit(c, F, Type::NEUTRAL);
-		fun.push_back(jit_insn_load_relative(F, fun_addr, 8, JIT_POINTER));
-	} else {
-		fun.push_back(function->compile_jit(c, F, Type::NEUTRAL));
+	// Function known at compile time : called directly, with its own signature
+	Function* callee = known_function();
+	if (callee != nullptr and callee == function) {
+		callee->compile_jit(c, F, Type::NEUTRAL);
+	}
+	if (callee != nullptr and (callee->jit_function == nullptr or callee->arguments.size() != arguments.size())) {
+		callee = nullptr;
+	}
+	const Type& function_type = callee != nullptr ? callee->type : function->type;
+
+	if (callee == nullptr) {
+		if (function->type.nature == Nature::POINTER) {
+			jit_value_t fun_addr = function->compile_jit(c, F, Type::NEUTRAL);
+			fun.push_back(jit_insn_load_relative(F, fun_addr, sizeof(LSValue), JIT_POINTER));
+		} else {
+			fun.push_back(function->compile_jit(c, F, Type::NEUTRAL));
+		}
 	}
 
 	int arg_count = arguments.size();
@@ -325,11 +431,11 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 	vector<jit_type_t> args_types;
 
 	for (int i = 0; i < arg_count; ++i) {
-		args.push_back(arguments[i]->compile_jit(c, F, function->type.getArgumentType(i)));
-		args_types.push_back(function->type.getArgumentType(i).nature != Nature::VALUE ? JIT_POINTER :
-				(function->type.getArgumentType(i).raw_type == RawType::FUNCTION) ? JIT_POINTER :
-				(function->type.getArgumentType(i).raw_type == RawType::FLOAT) ? JIT_FLOAT :
-				(function->type.getArgumentType(i).raw_type == RawType::LONG) ? JIT_INTEGER_LONG :
+		args.push_back(arguments[i]->compile_jit(c, F, function_type.getArgumentType(i)));
+		args_types.push_back(function_type.getArgumentType(i).nature != Nature::VALUE ? JIT_POINTER :
+				(function_type.getArgumentType(i).raw_type == RawType::FUNCTION) ? JIT_POINTER :
+				(function_type.getArgumentType(i).raw_type == RawType::FLOAT) ? JIT_FLOAT :
+				(function_type.getArgumentType(i).raw_type == RawType::LONG) ? JIT_INTEGER_LONG :
 				JIT_INTEGER);
 	}
 
@@ -343,7 +449,9 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, return_type, args_types.data(), arg_count, 0);
 
-	jit_value_t ret = jit_insn_call_indirect(F, fun[0], sig, args.data(), arg_count, JIT_CALL_NOTHROW);
+	jit_value_t ret = callee != nullptr
+		? jit_insn_call(F, "fun", callee->jit_function, nullptr, args.data(), arg_count, JIT_CALL_NOTHROW)
+		: jit_insn_call_indirect(F, fun[0], sig, args.data(), arg_count, JIT_CALL_NOTHROW);
 
 	//cout << "function call type " << type << endl;
 
@@ -354,3 +462,25 @@ jit_value_t FunctionCall::compile_jit(Compiler& c, jit_function_t& F, Type req_t
 	return ret;
 }
 
+/*
+ * Call of the current function as its result : the arguments replace the
+ * parameters and the body starts again, instead of a new call. Only for
+ * functions which have no pointer value to release before returning.
+ */
+bool FunctionCall::compile_tail_call(Compiler& c, jit_function_t& F, const Function* current) const {
+
+	if (current == nullptr or known_function() != current or current->jit_function != F
+		or arguments.size() != current->arguments.size() or not c.function_vars.back().empty()) {
+		return false;
+	}
+	vector<jit_value_t> args;
+	for (unsigned i = 0; i < arguments.size(); ++i) {
+		jit_value_t arg = arguments[i]->compile_jit(c, F, current->type.getArgumentType(i));
+		args.push_back(jit_insn_load(F, arg));
+	}
+	for (unsigned i = 0; i < arguments.size(); ++i) {
+		jit_insn_store(F, jit_value_get_param(F, i), args[i]);
+	}
+	jit_insn_branch(F, &current->tail_label);
+	return true;
+}
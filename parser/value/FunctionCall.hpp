@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Value.hpp"
+class Function;
 
 class FunctionCall : public Value {
 public:
@@ -23,8 +24,12 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
+
+	Function* known_function() const;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
+	bool compile_tail_call(Compiler&, jit_function_t&, const Function* current) const;
 };
 
 #endif
@@ -0,0 +1,137 @@
+#include "FusedLoop.hpp"
+#include "Function.hpp"
+#include "../instruction/Foreach.hpp"
+#include "../../vm/VM.hpp"
+#include "../../vm/value/LSNull.hpp"
+
+using namespace std;
+
+LSArray* fused_new_array() {
+	return new LSArray();
+}
+
+void fused_push_move(LSArray* array, LSValue* value) {
+	array->pushMove(value);
+}
+
+// The current element, already read by get_array_elem
+void fused_push_element(LSArray* array, ForeachIterator* it) {
+	if (it->it.array->associative) {
+		array->pushKeyClone(it->it.key(), it->it.value());
+	} else {
+		array->pushClone(it->number != nullptr ? it->number : it->it.value());
+	}
+}
+
+int fused_is_true(LSValue* value) {
+	return value->isTrue();
+}
+
+bool FusedLoop::get_kind(const string& method, Kind& kind) {
+	if (method == "map") kind = Kind::MAP;
+	else if (method == "filter") kind = Kind::FILTER;
+	else if (method == "iter") kind = Kind::ITER;
+	else if (method == "foldLeft") kind = Kind::FOLD_LEFT;
+	else return false;
+	return true;
+}
+
+unsigned FusedLoop::argument_count(Kind kind) {
+	return kind == Kind::FOLD_LEFT ? 2 : 1;
+}
+
+/*
+ * Same semantics as the methods of ArraySTD : the array and the initial value
+ * are kept alive during the loop, the results of the lambda are moved in the
+ * new array, or released (iter, filter)
+ */
+jit_value_t FusedLoop::compile(Compiler& c, jit_function_t& F, Kind kind, jit_value_t array, const Function* lambda, jit_value_t init) {
+
+	jit_label_t label_cond = jit_label_undefined;
+	jit_label_t label_next = jit_label_undefined;
+	jit_label_t label_end = jit_label_undefined;
+
+	jit_type_t args_1[1] = {JIT_POINTER};
+	jit_type_t args_2[2] = {JIT_POINTER, JIT_POINTER};
+	jit_type_t sig_pointer = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_1, 1, 0);
+	jit_type_t sig_integer = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER, args_1, 1, 0);
+	jit_type_t sig_void = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args_1, 1, 0);
+	jit_type_t sig_void_2 = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args_2, 2, 0);
+
+	VM::inc_refs(F, array);
+
+	// Result : a new array, or the accumulated value
+	jit_value_t result = jit_value_create(F, JIT_POINTER);
+	if (kind == Kind::MAP or kind == Kind::FILTER) {
+		jit_type_t sig_new = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, nullptr, 0, 0);
+		jit_insn_store(F, result, jit_insn_call_native(F, "new", (void*) fused_new_array, sig_new, nullptr, 0, JIT_CALL_NOTHROW));
+	} else if (kind == Kind::FOLD_LEFT) {
+		VM::inc_refs(F, init);
+		jit_insn_store(F, result, init);
+	} else {
+		jit_insn_store(F, result, JIT_CREATE_CONST_POINTER(F, LSNull::null_var));
+	}
+
+	jit_value_t it = jit_value_create(F, JIT_POINTER);
+	jit_insn_store(F, it, jit_insn_call_native(F, "begin", (void*) get_array_begin, sig_pointer, &array, 1, JIT_CALL_NOTHROW));
+
+	// cond label:
+	jit_insn_label(F, &label_cond);
+	jit_value_t at_end = jit_insn_call_native(F, "end", (void*) is_array_end, sig_integer, &it, 1, JIT_CALL_NOTHROW);
+	jit_insn_branch_if(F, at_end, &label_end);
+
+	jit_value_t value = jit_insn_call_native(F, "get", (void*) get_array_elem, sig_pointer, &it, 1, JIT_CALL_NOTHROW);
+
+	switch (kind) {
+		case Kind::MAP: {
+			jit_value_t r = lambda->compile_inline(c, F, {value}, Type::POINTER);
+			jit_value_t args[2] = {result, r};
+			jit_insn_call_native(F, "push", (void*) fused_push_move, sig_void_2, args, 2, JIT_CALL_NOTHROW);
+			break;
+		}
+		case Kind::FILTER: {
+			// A boolean or integer predicate is tested without being boxed
+			Type return_type = lambda->type.getReturnType();
+			if (return_type.nature == Nature::VALUE and (return_type.raw_type == RawType::BOOLEAN
+				or return_type.raw_type == RawType::INTEGER)) {
+				jit_value_t r = lambda->compile_inline(c, F, {value}, Type::NEUTRAL);
+				jit_insn_branch_if_not(F, r, &label_next);
+			} else {
+				jit_value_t r = lambda->compile_inline(c, F, {value}, Type::POINTER);
+				jit_value_t keep = jit_insn_call_native(F, "is_true", (void*) fused_is_true, sig_integer, &r, 1, JIT_CALL_NOTHROW);
+				VM::delete_temporary(F, r);
+				jit_insn_branch_if_not(F, keep, &label_next);
+			}
+			jit_value_t args[2] = {result, it};
+			jit_insn_call_native(F, "push", (void*) fused_push_element, sig_void_2, args, 2, JIT_CALL_NOTHROW);
+			break;
+		}
+		case Kind::ITER: {
+			jit_value_t r = lambda->compile_inline(c, F, {value}, Type::NEUTRAL);
+			if (lambda->type.getReturnType().nature == Nature::POINTER) {
+				VM::delete_temporary(F, r);
+			}
+			break;
+		}
+		case Kind::FOLD_LEFT: {
+			jit_insn_store(F, result, lambda->compile_inline(c, F, {result, value}, Type::POINTER));
+			break;
+		}
+	}
+
+	// it++
+	jit_insn_label(F, &label_next);
+	jit_insn_call_native(F, "inc", (void*) iterator_inc, sig_void, &it, 1, JIT_CALL_NOTHROW);
+	jit_insn_branch(F, &label_cond);
+
+	// end label:
+	jit_insn_label(F, &label_end);
+	jit_insn_call_native(F, "delete", (void*) iterator_delete, sig_void, &it, 1, JIT_CALL_NOTHROW);
+
+	if (kind == Kind::FOLD_LEFT) {
+		VM::delete_arg(F, init, result);
+	}
+	VM::delete_arg(F, array, result);
+
+	return result;
+}
@@ -0,0 +1,25 @@
+#ifndef FUSEDLOOP_HPP
+#define FUSEDLOOP_HPP
+
+#include <string>
+#include <jit/jit.h>
+#include "../../Compiler.hpp"
+class Function;
+
+/*
+ * Loop over the values of an array calling a lambda literal, compiled in the
+ * calling function with the body of the lambda inlined : no LSFunction and no
+ * call for each value. Used by map, filter, iter and foldLeft, and by ~~.
+ */
+class FusedLoop {
+public:
+
+	enum class Kind { MAP, FILTER, ITER, FOLD_LEFT };
+
+	static bool get_kind(const std::string& method, Kind& kind);
+	static unsigned argument_count(Kind kind);
+
+	static jit_value_t compile(Compiler&, jit_function_t&, Kind, jit_value_t array, const Function* lambda, jit_value_t init);
+};
+
+#endif
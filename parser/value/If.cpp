@@ -51,6 +51,14 @@ void If::analyse(SemanticAnalyser* analyser, const Type req_type) {
 	}
 }
 
+void If::fold() {
+	condition->fold();
+	then->fold();
+	if (elze != nullptr) {
+		elze->fold();
+	}
+}
+
 int is_true(LSValue* v) {
 	return v->isTrue();
 }
@@ -18,6 +18,7 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 };
@@ -19,7 +19,7 @@ void Nulll::analyse(SemanticAnalyser*, const Type) {}
 jit_value_t Nulll::compile_jit(Compiler&, jit_function_t& F, Type req_type) const {
 
 	if (req_type.nature == Nature::POINTER) {
-		LSNull* n = new LSNull();
+		LSNull* n = make_native(new LSNull());
 		return JIT_CREATE_CONST_POINTER(F, n);
 	} else {
 		return JIT_CREATE_CONST(F, JIT_INTEGER, 0);
@@ -11,6 +11,19 @@ Number::Number(double value) {
 
 Number::~Number() {}
 
+/*
+ * Literal for a value computed before the compilation, nullptr if it's not
+ * an integer (when one is expected)
+ */
+Number* Number::computed(double value, bool floating) {
+	if (!floating and (value != (int) value or value < INT_MIN or value > INT_MAX)) {
+		return nullptr;
+	}
+	Number* n = new Number(value);
+	n->type = floating ? Type::FLOAT : Type::INTEGER;
+	return n;
+}
+
 void Number::print(ostream& os) const {
 	os << value;
 }
@@ -32,7 +45,7 @@ jit_value_t Number::compile_jit(Compiler&, jit_function_t& F, Type req_type) con
 
 	if (req_type.nature == Nature::POINTER) {
 
-		LSNumber* n = LSNumber::get(value);
+		LSNumber* n = make_native(LSNumber::get(value));
 		return JIT_CREATE_CONST_POINTER(F, n);
 
 	} else {
@@ -10,6 +10,8 @@ public:
 	double value;
 
 	Number(double value);
+
+	static Number* computed(double value, bool floating);
 	virtual ~Number();
 
 	virtual void print(std::ostream&) const override;
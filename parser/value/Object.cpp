@@ -30,20 +30,30 @@ void Object::analyse(SemanticAnalyser* analyser, const Type) {
 	}
 }
 
+void Object::fold() {
+	for (Value* value : values) {
+		value->fold();
+	}
+}
+
+LSObject* LSObject_create() {
+	return new LSObject();
+}
+
 void push_object(LSObject* o, LSString* k, LSValue* v) {
-	o->addField(k->value, v);
+	o->addField(k->value, v->move());
 }
 
 jit_value_t Object::compile_jit(Compiler& c, jit_function_t& F, Type) const {
 
-	LSObject* o = new LSObject();
-	jit_value_t object = JIT_CREATE_CONST_POINTER(F, o);
+	jit_type_t create_sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, {}, 0, 0);
+	jit_value_t object = jit_insn_call_native(F, "new", (void*) LSObject_create, create_sig, {}, 0, JIT_CALL_NOTHROW);
 
 	jit_type_t args[3] = {JIT_POINTER, JIT_POINTER, JIT_POINTER};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 3, 0);
 
 	for (unsigned i = 0; i < keys.size(); ++i) {
-		jit_value_t k = JIT_CREATE_CONST_POINTER(F, new LSString(keys.at(i)->token->content));
+		jit_value_t k = JIT_CREATE_CONST_POINTER(F, make_native(new LSString(keys.at(i)->token->content)));
 		jit_value_t v = values[i]->compile_jit(c, F, Type::POINTER);
 		jit_value_t args[] = {object, k, v};
 		jit_insn_call_native(F, "push", (void*) push_object, sig, args, 3, JIT_CALL_NOTHROW);
@@ -3,6 +3,8 @@
 #include "../../vm/value/LSString.hpp"
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../Program.hpp"
+#include "Object.hpp"
+#include "VariableValue.hpp"
 
 using namespace std;
 
@@ -50,22 +52,53 @@ void ObjectAccess::analyse(SemanticAnalyser* analyser, const Type) {
 			attr_addr = ((LSFunction*) std_class->static_fields[field])->function;
 		}
 	}
+
+	element = -1;
+	VariableValue* vv = dynamic_cast<VariableValue*>(object);
+	Object* literal = vv != nullptr ? dynamic_cast<Object*>(vv->var->value) : nullptr;
+	if (literal != nullptr and not class_attr) {
+		for (unsigned i = 0; i < literal->keys.size(); ++i) {
+			if (literal->keys[i]->token->content == field) {
+				element = i;
+			}
+		}
+		if (element != -1) {
+			vv->var->element_uses++;
+			analyser->element_reads.push_back({vv->var, &scalar});
+			if (scalar) {
+				type = literal->values[element]->type;
+			}
+		}
+	}
+}
+
+void ObjectAccess::fold() {
+	object->fold();
 }
 
 LSValue* object_access(LSValue* o, LSString* k) {
-	return o->attr(k);
+	LSValue* res = o->attr(k);
+	// Release a temporary object, keeping the attribute alive
+	LSValue::inc_refs(res);
+	LSValue::delete_temporary(o);
+	LSValue::dec_refs(res);
+	return res;
 }
 
 LSValue** object_access_l(LSValue* o, LSString* k) {
 	return o->attrL(k);
 }
 
-jit_value_t ObjectAccess::compile_jit(Compiler& c, jit_function_t& F, Type) const {
+jit_value_t ObjectAccess::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
+
+	if (element != -1 and ((VariableValue*) object)->var->scalar_replaced()) {
+		return ((VariableValue*) object)->compile_element(c, F, element, scalar ? req_type : Type::POINTER);
+	}
 
 	if (class_attr) {
 
 		// TODO : only functions!
-		return JIT_CREATE_CONST_POINTER(F, new LSFunction(attr_addr));
+		return JIT_CREATE_CONST_POINTER(F, make_native(new LSFunction(attr_addr)));
 
 	} else {
 
@@ -74,7 +107,7 @@ jit_value_t ObjectAccess::compile_jit(Compiler& c, jit_function_t& F, Type) cons
 		jit_type_t args_types[2] = {JIT_POINTER, JIT_POINTER};
 		jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 2, 0);
 
-		jit_value_t k = JIT_CREATE_CONST_POINTER(F,  new LSString(field));
+		jit_value_t k = JIT_CREATE_CONST_POINTER(F, make_native(new LSString(field)));
 		jit_value_t args[] = {o, k};
 		return jit_insn_call_native(F, "access", (void*) object_access, sig, args, 2, JIT_CALL_NOTHROW);
 	}
@@ -87,7 +120,7 @@ jit_value_t ObjectAccess::compile_jit_l(Compiler& c, jit_function_t& F, Type) co
 	jit_type_t args_types[2] = {JIT_POINTER, JIT_POINTER};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 2, 0);
 
-	jit_value_t k = JIT_CREATE_CONST_POINTER(F,  new LSString(field));
+	jit_value_t k = JIT_CREATE_CONST_POINTER(F, make_native(new LSString(field)));
 	jit_value_t args[] = {o, k};
 	return jit_insn_call_native(F, "access_l", (void*) object_access_l, sig, args, 2, JIT_CALL_NOTHROW);
 }
@@ -12,6 +12,10 @@ public:
 	std::string field;
 	bool class_attr = false;
 	void* attr_addr;
+	// Index of the field read in the literal object of a variable, -1 otherwise
+	int element = -1;
+	// The field is scalar replaced : the access is typed as its value
+	bool scalar = false;
 
 	ObjectAccess();
 	virtual ~ObjectAccess();
@@ -19,6 +23,7 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
 
@@ -1,6 +1,8 @@
 #include "../../vm/VM.hpp"
 #include "PostfixExpression.hpp"
 #include "LeftValue.hpp"
+#include "VariableValue.hpp"
+#include "../semantic/SemanticAnalyser.hpp"
 
 using namespace std;
 
@@ -21,6 +23,12 @@ void PostfixExpression::analyse(SemanticAnalyser* analyser, const Type) {
 	expression->analyse(analyser);
 	type = expression->type;
 	this->return_value = return_value;
+
+	SemanticVar* assigned = SemanticAnalyser::assigned_var(expression);
+	if (assigned != nullptr) {
+		assigned->assignments++;
+	}
+	SemanticAnalyser::changed_in_place(expression);
 }
 
 extern LSValue* jit_inc(LSValue*);
@@ -2,6 +2,10 @@
 #include "LeftValue.hpp"
 #include "VariableValue.hpp"
 #include "FunctionCall.hpp"
+#include "Number.hpp"
+#include "Boolean.hpp"
+#include "../semantic/SemanticAnalyser.hpp"
+#include "../instruction/LoopMotion.hpp"
 #include "../../vm/VM.hpp"
 
 using namespace std;
@@ -21,6 +25,35 @@ void PrefixExpression::print(ostream& os) const {
 void PrefixExpression::analyse(SemanticAnalyser* analyser, const Type) {
 	expression->analyse(analyser);
 	type = expression->type;
+
+	if (operatorr->type == TokenType::PLUS_PLUS or operatorr->type == TokenType::MINUS_MINUS) {
+		SemanticVar* assigned = SemanticAnalyser::assigned_var(expression);
+		if (assigned != nullptr) {
+			assigned->assignments++;
+		}
+		SemanticAnalyser::changed_in_place(expression);
+	}
+}
+
+void PrefixExpression::fold() {
+
+	expression->fold();
+
+	const Value* l = expression->literal();
+	if (l == nullptr or type.nature != Nature::VALUE) {
+		return;
+	}
+	if (const Number* n = dynamic_cast<const Number*>(l)) {
+		if (operatorr->type == TokenType::MINUS) {
+			folded = Number::computed(-n->value, n->type.raw_type == RawType::FLOAT);
+		} else if (operatorr->type == TokenType::NOT) {
+			folded = new Boolean(n->value == 0);
+		}
+	} else if (const Boolean* b = dynamic_cast<const Boolean*>(l)) {
+		if (operatorr->type == TokenType::NOT) {
+			folded = new Boolean(!b->value);
+		}
+	}
 }
 
 extern LSValue* jit_not(LSValue*);
@@ -29,11 +62,20 @@ extern LSValue* jit_pre_inc(LSValue*);
 extern LSValue* jit_pre_dec(LSValue*);
 
 LSValue* jit_pre_tilde(LSValue* v) {
-	return v->operator ~ ();
+	LSValue* r = v->operator ~ ();
+	if (r != v) LSValue::delete_temporary(v);
+	return r;
 }
 
 jit_value_t PrefixExpression::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
 
+	if (folded != nullptr) {
+		return folded->compile_jit(c, F, req_type);
+	}
+	if (jit_value_t moved = LoopMotion::compile_moved(c, F, this, req_type)) {
+		return moved;
+	}
+
 	jit_type_t args_types[1] = {JIT_POINTER};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
 	vector<jit_value_t> args;
@@ -119,10 +161,10 @@ jit_value_t PrefixExpression::compile_jit(Compiler& c, jit_function_t& F, Type r
 					return n;
 				}
 				if (vv->name->content == "String") {
-					return JIT_CREATE_CONST_POINTER(F,  new LSString(""));
+					return JIT_CREATE_CONST_POINTER(F, make_native(new LSString("")));
 				}
 				if (vv->name->content == "Array") {
-					return JIT_CREATE_CONST_POINTER(F,  new LSArray());
+					return JIT_CREATE_CONST_POINTER(F, make_native(new LSArray()));
 				}
 			}
 
@@ -143,10 +185,10 @@ jit_value_t PrefixExpression::compile_jit(Compiler& c, jit_function_t& F, Type r
 						if (fc->arguments.size() > 0) {
 							return fc->arguments[0]->compile_jit(c, F, Type::POINTER);
 						}
-						return JIT_CREATE_CONST_POINTER(F, new LSString(""));
+						return JIT_CREATE_CONST_POINTER(F, make_native(new LSString("")));
 					}
 					if (vv->name->content == "Array") {
-						return JIT_CREATE_CONST_POINTER(F, new LSArray());
+						return JIT_CREATE_CONST_POINTER(F, make_native(new LSArray()));
 					}
 				}
 			}
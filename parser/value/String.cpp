@@ -21,6 +21,6 @@ void String::analyse(SemanticAnalyser*, const Type) {}
 
 jit_value_t String::compile_jit(Compiler&, jit_function_t& F, Type) const {
 
-	LSString* s = new LSString(value);
+	LSString* s = make_native(new LSString(value));
 	return JIT_CREATE_CONST_POINTER(F,  s);
 }
@@ -1,11 +1,16 @@
 #include "Value.hpp"
+#include "Number.hpp"
+#include "Boolean.hpp"
+#include "String.hpp"
 
 Value::Value() {
 	type = Type::NEUTRAL;
 	constant = false;
 }
 
-Value::~Value() {}
+Value::~Value() {
+	delete folded;
+}
 
 void Value::analyse(SemanticAnalyser* analyser) {
 	analyse(analyser, Type::NEUTRAL);
@@ -19,3 +24,18 @@ bool Value::isLeftValue() const {
 	return false;
 }
 
+
+void Value::fold() {}
+
+/*
+ * The Number, Boolean or String literal this value is equal to, if known
+ */
+const Value* Value::literal() const {
+	if (folded != nullptr) {
+		return folded;
+	}
+	if (dynamic_cast<const Number*>(this) or dynamic_cast<const Boolean*>(this) or dynamic_cast<const String*>(this)) {
+		return this;
+	}
+	return nullptr;
+}
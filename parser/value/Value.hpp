@@ -12,6 +12,9 @@ public:
 	std::map<std::string, Type> attr_types;
 	bool constant;
 	bool parenthesis = false;
+	// Literal equal to the value when it's known before the compilation,
+	// computed by fold() and compiled instead of the value
+	Value* folded = nullptr;
 
 	Value();
 	virtual ~Value();
@@ -24,6 +27,9 @@ public:
 	virtual bool will_take(SemanticAnalyser*, const unsigned, const Type);
 	virtual void analyse(SemanticAnalyser*, const Type) = 0;
 
+	virtual void fold();
+	virtual const Value* literal() const;
+
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const = 0;
 };
 
@@ -2,6 +2,8 @@
 #include "../semantic/SemanticAnalyser.hpp"
 #include "../../vm/VM.hpp"
 #include "Function.hpp"
+#include "Number.hpp"
+#include "Boolean.hpp"
 #include "math.h"
 
 using namespace std;
@@ -21,6 +23,7 @@ void VariableValue::print(ostream& os) const {
 void VariableValue::analyse(SemanticAnalyser* analyser, const Type) {
 
 	var = analyser->get_var(name);
+	var->uses++;
 	type = var->type;
 	attr_types = var->attr_types;
 
@@ -30,12 +33,30 @@ void VariableValue::analyse(SemanticAnalyser* analyser, const Type) {
 	//	cout << t.first << " : " << t.second << endl;
 }
 
-extern map<string, jit_value_t> internals;
-extern map<string, jit_value_t> globals;
-extern map<string, jit_value_t> locals;
+/*
+ * A variable declared with a number or a boolean and never assigned after
+ * is replaced by this value
+ */
+void VariableValue::fold() {
 
+	if (var == nullptr or var->value == nullptr or var->assignments > 0 or type.nature != Nature::VALUE
+		or (var->scope != VarScope::LOCAL and var->scope != VarScope::GLOBAL)) {
+		return;
+	}
+	const Value* l = var->value->literal();
+	if (const Number* n = dynamic_cast<const Number*>(l)) {
+		folded = Number::computed(n->value, type.raw_type == RawType::FLOAT);
+	} else if (const Boolean* b = dynamic_cast<const Boolean*>(l)) {
+		folded = new Boolean(b->value);
+	}
+}
+
+
+jit_value_t VariableValue::compile_jit(Compiler& c, jit_function_t& F, Type req_type) const {
 
-jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_type) const {
+	if (folded != nullptr) {
+		return folded->compile_jit(c, F, req_type);
+	}
 
 //	cout << "compile vv " << name->content << " : " << type << endl;
 //	cout << "req type : " << req_type << endl;
@@ -45,7 +66,7 @@ jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_ty
 
 //		cout << "internal" << endl;
 
-		jit_value_t v = internals[name->content];
+		jit_value_t v = c.internals[name->content];
 		if (var->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
 			return VM::value_to_pointer(F, v, req_type);
 		}
@@ -55,7 +76,7 @@ jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_ty
 
 //		cout << "global var : " << name->content << endl;
 
-		jit_value_t v = globals[name->content];
+		jit_value_t v = c.globals[name->content];
 		if (var->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
 			return VM::value_to_pointer(F, v, req_type);
 		}
@@ -63,7 +84,7 @@ jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_ty
 
 	} else if (var->scope == VarScope::LOCAL) {
 
-		jit_value_t v = locals[name->content];
+		jit_value_t v = c.locals[name->content];
 		if (var->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
 			cout << "convert local" << endl;
 			return VM::value_to_pointer(F, v, req_type);
@@ -74,7 +95,8 @@ jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_ty
 
 //		cout << "Compile arg : " << type << endl;
 
-		jit_value_t v = jit_value_get_param(F, var->index);
+		jit_value_t v = c.inlined_arguments != nullptr ? c.inlined_arguments->at(var->index)
+			: jit_value_get_param(F, var->index);
 		if (var->type.nature != Nature::POINTER and req_type.nature == Nature::POINTER) {
 			return VM::value_to_pointer(F, v, req_type);
 		}
@@ -82,6 +104,18 @@ jit_value_t VariableValue::compile_jit(Compiler&, jit_function_t& F, Type req_ty
 	}
 }
 
+/*
+ * Element of the literal value of the variable, kept in a variable by its declaration
+ */
+jit_value_t VariableValue::compile_element(Compiler& c, jit_function_t& F, int index, Type req_type) const {
+
+	jit_value_t v = c.scalar_elements.at(var).at(index);
+	if (req_type.nature == Nature::POINTER) {
+		return VM::value_to_pointer(F, v, var->literal_elements()->at(index)->type);
+	}
+	return v;
+}
+
 jit_value_t VariableValue::compile_jit_l(Compiler& c, jit_function_t& F, Type) const {
 
 	return compile_jit(c, F, type);
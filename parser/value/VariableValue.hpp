@@ -19,9 +19,11 @@ public:
 	virtual void print(std::ostream&) const override;
 
 	virtual void analyse(SemanticAnalyser*, const Type) override;
+	virtual void fold() override;
 	void must_take(SemanticAnalyser* analyser, const Type& type);
 
 	virtual jit_value_t compile_jit(Compiler&, jit_function_t&, Type) const override;
+	jit_value_t compile_element(Compiler&, jit_function_t&, int index, Type) const;
 	virtual jit_value_t compile_jit_l(Compiler&, jit_function_t&, Type) const override;
 };
 
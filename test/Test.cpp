@@ -1,9 +1,16 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <vector>
 
 #include "Test.hpp"
+#include "../vm/Server.hpp"
 #include "../vm/Context.hpp"
+#include "../vm/Sha256.hpp"
+#include "../parser/lexical/TokenFile.hpp"
 #include "../parser/lexical/LexicalAnalyser.hpp"
 #include "../parser/syntaxic/SyntaxicAnalyser.hpp"
 #include "../parser/semantic/SemanticAnalyser.hpp"
@@ -42,6 +49,12 @@ void Test::tests() {
 	test("let a", "null");
 	test("let a a = 12 a", "12");
 	test("let a = 1 let b = (a = 12)", "12");
+	test("let a = [1, 2] let b = a b.push(3) a", "[1, 2]");
+	test("let a = [1] a = [2] a = a + [3] a", "[2, 3]");
+	test("if (false) { let a = [1] } 5", "5");
+	test("let a = 5 let f = -> a * 2 f()", "10");
+	test("let a = 5 a++ a * 2", "12");
+	test("let a = 1 let b = 2 a <=> b a - b", "1");
 
 	/*
 	 * Booléens
@@ -94,6 +107,8 @@ void Test::tests() {
 	test("12 == (24 / 2)", "true");
 	test("2.5 + 4.7", "7.2");
 	test("2.5 × 4.7", "11.75");
+	// -0.0 boxed is not the cached 0
+	test("let a = [1, 'a'] a[0] = -0.0 * 1 1 / a[0]", "-inf");
 	// test("12344532132423", "12344532132423");
 	test("π", "3.1415926536");
 
@@ -102,9 +117,15 @@ void Test::tests() {
 	 */
 	header("Operations");
 	test("5 * 2 + 3 * 4", "22");
+	test("let x = 3 (2 * 3 + 4) * x", "30");
+	test("-(3 + 4) * 1 / 4", "-1.75");
+	test("7 % 3 == 1 and !(1 > 2)", "true");
+	test("'sa' + 'lut' + ' !'", "'salut !'");
 	test("let f = x -> x f(5) + f(7)", "12");
 	test("'salut' * (1 + 2)", "'salutsalutsalut'");
 	test("('salut' * 1) + 2", "'salut2'");
+	test("let a = [1, 'a'] [a[0] * 2.5, a[0] < 2, a[0] == 1]", "[2.5, true, true]");
+	test("let a = ['x', 'y', 2] [a[0] + a[1], a[0] + a[2], a[2] + a[1]]", "['xy', 'x2', '2y']");
 
 	/*
 	 * Arrays
@@ -121,15 +142,22 @@ void Test::tests() {
 	test("let a = [1, 2, 3] a[0]", "1");
 	test("let a = [1, 2, 3] a[0] += 5 a[0]", "6");
 	test("let v = 12 let a = [v, 2, 3] a[0] += 5 a[0]", "17");
+	test("let a = [1.5, 2.5] [a[0] + a[1], a]", "[4, [1.5, 2.5]]");
+	test("let a = [1, 2, 3] a[1]++ a[2] *= 3 [a[0], a]", "[1, [1, 3, 9]]");
+	test("let a = [1, 2, 3] let b = [] for x in a { b.push(x * 2) } b", "[2, 4, 6]");
+	test("let a = [1, 2, 3] let b = [] for x in a { a[0] = 'x' b.push(x) } [a, b]", "[['x', 2, 3], [1, 2, 3]]");
 	test("let a = [23, 23, true, '', [], 123] |a|", "6");
 	test("let a = [1, 2, 3]; ~a", "[3, 2, 1]");
 	test("let a = [1, 2, 3] a[1] = 12 a", "[1, 12, 3]");
+	test("let a = [[1], [2]] a[0] = [5] a", "[[5], [2]]");
 	test("[1.2, 321.42, 23.15]", "[1.2, 321.42, 23.15]");
 	test("[1, 2, 3, 4, 5][1:3]", "[2, 3, 4]");
 	test("2 in [1, 2, 3]", "true");
 	test("4 in [1, 2, 3]", "false");
 	test("'yo' in ['ya', 'yu', 'yo']", "true");
 	test("let a = 2 if (a in [1, 2, 3]) { 'ok' } else { 'no' }", "'ok'");
+	test("let a = [1, 2, 3] a.removeKey(1) a", "[0: 1, 2: 3]");
+	test("let a = [5, 6, 7] let s = '' for k : v in a { s += k + ':' + v + ' ' } s", "'0:5 1:6 2:7 '");
 
 	// let a = [1..100]
 	// let a = [for let i = 0; i < 100; i++ do i end]
@@ -161,6 +189,13 @@ void Test::tests() {
 	test("let a = {b: 12, c: 5} a.b", "12");
 	test("let a = {b: 12, c: 5} a.b *= 10", "120");
 	test("let a = {a: 32, b: 'toto', c: false} |a|", "3");
+	test("let a = {b: [1, 2]} let c = a.b c[0] = 5 a.b", "[1, 2]");
+	test("let f = function() { let r = [] let i = 0 while i < 5 { let t = [i, i * 2] let o = {x: i + 1, y: 2} r.push(t[0] * t[1] + o.x * o.y) i++ } return r } f()", "[2, 6, 14, 26, 42]");
+	test("let f = function() { let i = 3 let t = [i, 4] t[1] = 5 return t[0] + t[1] } f()", "8");
+	test("let f = function() { let i = 3 let o = {a: i, b: 4} } f()", "{a: 3, b: 4}");
+	// The elements read are not boxed : no more memory than the values themselves
+	test_memory("let f = function() { let t = [1.5, 2.5] let o = {x: 0.5} return [t[0] * o.x, t[1] - t[0]] } f()",
+		"let f = function() { return [1.5 * 0.5, 2.5 - 1.5] } f()");
 
 	/*
 	 * Références
@@ -191,6 +226,7 @@ void Test::tests() {
 	test("(x -> x)(12)", "12");
 	test("(x, y -> x + y)(12, 5)", "17");
 	test("( -> [])()", "[]");
+	test("let f = function(x) { x += 1 return x } [f(5), f(5)]", "[6, 6]");
 	test("( -> 12)()", "12");
 	test("[-> 12][0]()", "12");
 	test("[-> 12, 'toto'][0]()", "12");
@@ -203,13 +239,13 @@ void Test::tests() {
 
 	/*
 	test("let a = 5 let f = -> a f()", "5");
-
+*/
 	test("let f = x -> x (-> f(12))()", "12");
-
 	test("let f = x -> x let g = x -> f(x) g(12)", "12");
-
 	test("let g = x -> x ^ 2 let f = x, y -> g(x + y) f(6, 2)", "64");
-*/
+	test("let fact = function(n) { if (n <= 1) { return 1 } return n * fact(n - 1) } fact(10)", "3628800");
+	test("let f = function(n, s) { if (n == 0) { return s } return f(n - 1, s + n) } f(10000, 0)", "50005000");
+	test("let f = function(s, n) { if (n == 0) { return s } return f(s + 'a', n - 1) } f('', 3)", "'aaa'");
 
 	test("(-> -> 12)()()", "12");
 	test("let f = -> -> 12 f()()", "12");
@@ -240,6 +276,7 @@ void Test::tests() {
 	test("let i = 0 let s = 0 while (i < 10) { s += i i++ } s", "45");
 	test("let i = 0 while (i < 100) { i++ if (i == 50) break } i", "50");
 	test("let i = 0 let a = 0 while (i < 10) { i++ if (i < 8) continue a++ } a", "3");
+	test("let a = 3 let s = 0 let i = 0 while (i < a * 4) { i++ s += a * a } s", "108");
 
 	/*
 	 * For loops
@@ -253,6 +290,9 @@ void Test::tests() {
 	test("let i = 0 for i = 0; i < 10; i++ { if i == 5 { break } } i", "5");
 	test("let a = 0 for let i = 0; i < 10; i++ { a++ } a", "10");
 	test("let a = 0 for let i = 0; i < 10; i++ { if i < 5 { continue } a++ } a", "5");
+	test("let s = 0 for let k = 1; 36 * k * k - 12 * k < 1000; k++ { s++ } s", "5");
+	test("let r = [] for let k = 10; k * k > 5; k -= 3 { r.push(k * k - 2 * k) } r", "[80, 35, 8]");
+	test("let a = 3 let s = 0 for let i = 0; i < 5; i++ { s += a * 2 + i } s", "40");
 
 	/*
 	 * Foreach loops
@@ -261,6 +301,10 @@ void Test::tests() {
 	test("let s = 0 for v in [1, 2, 3, 4] { s += v } s", "10");
 	test("let s = '' for v in ['salut ', 'ça ', 'va ?'] { s += v } s", "'salut ça va ?'");
 	test("let s = 0 for k : v in [1, 2, 3, 4] { s += k * v } s", "18");
+	test("let s = 0 for k : v in [5, 6, 7] { if (k == 1) { continue } s += v } s", "12");
+	test("let a = ['a', 'b', 'c'] let s = '' for x in a { a = [] s += x } s", "'abc'");
+	test("let a = ['a', 'b'] let s = '' for x in a { a[0] = 'z' s += x } s", "'ab'");
+	test("let a = ['a', 'b', 'c'] let s = '' for x in a { if (x == 'b') { continue } s += x } s", "'ac'");
 
 	/*
 	 * Array operations
@@ -273,6 +317,29 @@ void Test::tests() {
 	test("[1, 2, 3] ~~ x -> 'yo'", "['yo', 'yo', 'yo']");
 	test("let f = x -> x * 10 [1, 2, 3] ~~ f", "[10, 20, 30]");
 	test("[1.2, 321.42, 23.15] ~~ x -> x * 1.7", "[2.04, 546.414, 39.355]");
+	test("[[1, 2], [3]] ~~ x -> x ~~ y -> y * 2", "[[2, 4], [6]]");
+
+	// Element-wise operators
+	test("[1, 2, 3] ~+ 1", "[2, 3, 4]");
+	test("[1, 2, 3] ~* 2.5", "[2.5, 5, 7.5]");
+	test("[1, 2, 3] ~/ 2", "[0.5, 1, 1.5]");
+	test("10 ~- [1, 2, 3]", "[9, 8, 7]");
+	test("[1.5, 2.5] ~- [1, 1, 1]", "[0.5, 1.5]");
+	test("[1, 2, 3] ~+ [10, 20, 30] ~* 2", "[21, 42, 63]");
+	test("[2147483647] ~+ 1", "[-2147483648]");
+	test("5 ~/ 2", "2.5");
+	test("['a', 'b'] ~+ 'c'", "['ac', 'bc']");
+	test("[1, 'b'] ~+ [2, 'c']", "[3, 'bc']");
+	test("let f = function(a, b) { return a ~* b } f([1, 2], 3)", "[3, 6]");
+	test("let a = [1, 2, 3] let b = a a ~*= 5 [a, b]", "[[5, 10, 15], [1, 2, 3]]");
+	test("let a = [1, 2, 3] a ~/= 2 a", "[0.5, 1, 1.5]");
+	test("let a = [1, 2] a ~+= a a", "[2, 4]");
+	test("let a = ['x', 'y'] a ~+= '!' a", "['x!', 'y!']");
+	test("let x = 12 x ~+= 3 x", "15");
+	test("let f = x -> x ~* 2 [f(3), f([1, 2])]", "[6, [2, 4]]");
+	test("let a = 5 a ~*= [1, 2] a", "<error>");
+	test("let a = [5, 5] a ~*= [1, 2] a", "[5, 10]");
+	test("let d = [3, 4] (d ~* d).sum()", "25");
 
 	/*
 	 * Swap
@@ -353,6 +420,7 @@ void Test::tests() {
 	test("Number.round(5.4)", "5");
 	test("Number.ceil(5.1)", "6");
 	test("Number.max(5, 12)", "12");
+	test("Number.sqrt(16) + Number.floor(2.5)", "6");
 	test("Number.cos(0)", "1");
 	test("Number.cos(π)", "-1");
 	test("Number.cos(π / 2)", "0");
@@ -395,14 +463,24 @@ void Test::tests() {
 	test("[1, 'yo', true].size()", "3");
 	test("Array.average([1, 2, 3, 4, 5, 6])", "3.5");
 	test("Array.average([])", "0");
+	test("[4.5, 1.5, 2.5].max()", "4.5");
+	test("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11].sum()", "66");
+	test("[3, 9, -2, 14, 5, 7, 1, 0, 13, -8, 2].max()", "14");
+	test("[3, 9, -2, 14, 5, 7, 1, 0, 13, -8, 2].min()", "-8");
+	test("[1.5, 2.5, -3.5, 4.5, 15.5, 6.5, 7.5, 8.5, 9.5].min()", "-3.5");
+	test("Array.average([2, 4, 6, 8, 10, 12, 14, 16, 18])", "10");
+	test("let a = [1, 2, 3] a.push('a') a", "[1, 2, 3, 'a']");
 	test("Array.map([1, 2, 3], x -> x ^ 2)", "[1, 4, 9]");
 	test("[3, 4, 5].map(x -> x ^ 2)", "[9, 16, 25]");
 	test("Array.map2([1, 'yo ', []], [12, 55, 9], (x, y -> x + y))", "[13, 'yo 55', [9]]");
 	test("[321, 213, 121].map(x -> x ^ 2).size()", "3");
 	test("Array.filter([1, 2, 3, 10, true, 'yo'], x -> x > 2)", "[3, 10, 'yo']");
 	test("[3, 4, 5].filter(x -> x > 6)", "[]");
+	test("[1, 2, 3, 10, true, 'yo'].filter(x -> x > 2)", "[3, 10, 'yo']");
 	test("Array.contains([1, 2, 3, 10, 1], 1)", "true");
 	test("[3, 4, 5].contains(6)", "false");
+	test("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11].contains(11)", "true");
+	test("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11].contains(4.5)", "false");
 	test("Array.isEmpty([])", "true");
 	test("[3, 4, 5].isEmpty()", "false");
 	//test("let a = 0 Array.iter([1,2,3], x -> a += x) a", "6");
@@ -419,6 +497,9 @@ void Test::tests() {
 
 	test("Array.foldLeft([1, 2, 3, 10, true, 'yo', null], (x, y -> x + y), 'concat:')", "'concat:12310trueyonull'");
 	test("Array.foldRight([1, 2, 3, 10, true, 'yo', null], (x, y -> x + y), 'concat:')", "16");
+	test("[1, 2, 3, 10, true, 'yo', null].foldLeft((x, y -> x + y), 'concat:')", "'concat:12310trueyonull'");
+	test("[].foldLeft((x, y -> x + y), [12])", "[12]");
+	test("[1, 2, 3].iter(x -> [x])", "null");
 //	test("Array.shuffle([1, 2, 3, 10, true, 'yo', null])", "test shuffle ?");
 	test("Array.reverse([1, 2, 3, 10, true, 'yo', null])", "[null, 'yo', true, 10, 3, 2, 1]");
 	test("[null].reverse()", "[null]");
@@ -428,6 +509,13 @@ void Test::tests() {
 	test("Array.search([1, 2, 3, 10, true, 'yo', null], false, 0)", "null");
 	test("Array.search([1, 2, 3, 10, true, 'yo', null], false, 0)", "null");
 	test("[null].search(null, 0)", "0");
+	test("Array.search([5, 6, 7, 8, 9, 10, 11, 12, 13], 12, 2)", "7");
+	test("Array.search([5, 6, 7, 8, 9, 10, 11, 12, 13], 6, 2)", "null");
+	test("[5, 6, 7].search(6, 100000000000000000000)", "null");
+	test("[5, 6, 7].search(6, -100000000000000000000)", "1");
+	test("[5, 6, 7].search(0 / 0, 0)", "null");
+	test("[5.5, 6.5].search(6.5, 0 / 0)", "1");
+	test("[1, 2].contains(0 / 0)", "false");
 	test("Array.subArray([1, 2, 3, 10, true, 'yo', null], 3, 6)", "[10, true, 'yo', null]");
 	test("Array.subArray([1, 2, 3, 10, true, 'yo', null], 3, -1)", "[]");
 	test("Array.subArray([1, 2, 3, 10, true, 'yo', null], -100, 100)", "[1, 2, 3, 10, true, 'yo', null]");
@@ -448,6 +536,8 @@ void Test::tests() {
 	test("let a = [1, 2, 3] Array.clear(a)", "[]");
 	test("let a = [1, 2, 3] a.fill(-1, 4) a", "[-1, -1, -1, -1]");
 	test("let a = [1, 2, 3] Array.fill(a, 'test', 2)", "['test', 'test']");
+	test("let a = ['a'] a.fill(2.5, 10) a.sum()", "25");
+	test("let a = [] a.fill(3, 3) a.push('b') a", "[3, 3, 3, 'b']");
 	test("let a = [1, 2, 3] Array.insert(a, 'test', 1)", "[1, 'test', 3]");
 	test("let a = [1, 2, 3] Array.insert(a, 'test', 6)", "[0: 1, 1: 2, 2: 3, 6: 'test']");
 	test("let a = [1, 2, 3] Array.insert(a, 'test', 'key')", "[0: 1, 1: 2, 2: 3, 'key': 'test']");
@@ -476,6 +566,59 @@ void Test::tests() {
 	header("Other");
 	test("var f = obj -> obj.a [f(12), f({a: 'yo'})]", "[null, 'yo']");
 
+	// Executed twice : the second time runs the cached program
+	test("let a = ['a', 2] a.push(1 + 2) a += 'b' a", "['a', 2, 3, 'b']");
+	test("let a = ['a', 2] a.push(1 + 2) a += 'b' a", "['a', 2, 3, 'b']");
+
+	// Stopped when the values of the execution exceed the heap cap
+	vm.heap_cap = 1024 * 1024;
+	test("let a = [] while (true) { a.push('hello') }", "<error>");
+	test("let a = [1] while (true) { a.push(a) }", "<error>");
+	test("let s = 'a' while (true) { s += s }", "<error>");
+	test("let a = [] while (true) { a.push(1.5) }", "<error>");
+	// Without any loop, the program is stopped at its end
+	vm.heap_cap = 64;
+	test("let a = [1, 2] let b = [a, a, 'hello'] b", "<error>");
+	// A live context is emptied by a stopped execution
+	vm.heap_cap = 1024 * 1024;
+	test_context({"var a = [1, 2]", "var b = [] while (true) { b.push(a) }", "var a = 12 a"}, "12");
+	vm.heap_cap = VM::DEFAULT_HEAP_CAP;
+
+	// Stopped when the operations of the execution exceed the limit
+	vm.operations_limit = 1000;
+	test("let i = 0 while (true) { i++ }", "<error>");
+	test("let s = 0 for (let i = 0; i < 100; i++) { s += i } s", "4950");
+	test("let f = function(n) { if (n < 0) { return 0 } return f(n + 1) } f(0)", "<error>");
+	vm.operations_limit = 0;
+
+	// Several VMs running at once
+	test_threads("let a = [1, 2, 3].map(x -> x * 2) let s = 0 for (let i = 0; i < 1000; i++) { s += i } a + s", "[2, 4, 6, 499500]");
+	test_threads("let o = {a: 'hello'} o.a + ' ' + [1, 2].size()", "'hello 2'");
+	test_batch(500, 4);
+	test_file("let o = {a: [1, 2, 3]} let f = function(x, y) { return x * y } let g = a, b -> a - b let i = 0 while (i < 2) { i++ } let s = 7 if s > 5 { s = -s } else { s = 0 } let t = [f(s, 2), g(5, 1), i, --i, 'b' + 1, o.a[1], true, null, (1 + 2) * 3, | -3 |] for k : v in ['x', 'y'] { t.push(k) } t",
+		"[-14, 4, 2, 1, 'b1', 2, true, null, 9, 3, 0, 1]");
+	test_programs_cap({{"1 + 1", "2"}, {"[1, 2]", "[1, 2]"}, {"'a' + 'b'", "'ab'"}, {"let f = x -> x * 3 f(4)", "12"}}, 2);
+	test_server("{\"id\": 7, \"code\": \"a + 1\", \"context\": {\"a\": {\"t\": 3, \"v\": 41}}}", "{\"id\":7,\"success\":true", "\"res\":\"42\"}");
+	test_server("{\"id\": 1234567, \"code\": \"1\"}", "{\"id\":1234567,\"success\":true", "\"res\":\"1\"}");
+	test_server("{\"code\": \"while (true) {}\", \"limits\": {\"operations\": 100}}", "{\"success\":false", "\"operations\":100,\"errors\":[{\"message\":\"Too many operations\"}]}");
+	// The limits of a job can't raise the ones of the server
+	vm.operations_limit = 1000;
+	test_server("{\"code\": \"while (true) {}\", \"limits\": {\"memory\": 0, \"operations\": 0}}", "{\"success\":false", "\"operations\":1000,\"errors\":[{\"message\":\"Too many operations\"}]}");
+	test_server("{\"code\": \"while (true) {}\", \"limits\": {\"operations\": 100000}}", "{\"success\":false", "\"operations\":1000,\"errors\":[{\"message\":\"Too many operations\"}]}");
+	vm.operations_limit = 0;
+	test_server("{\"code\": 12}", "{\"success\":false", "\"Invalid job\"}]}");
+	test_server("{\"code\": \"'" + string(100, 'a') + "'\"}", "{\"success\":false", "\"Job too long\"}]}", 64);
+	test_server("{\"code\": \"'" + string(100, 'a') + "'\"}", "{\"success\":true", "\"res\":\"'" + string(100, 'a') + "'\"}", 0);
+	test_server("{\"code\": \"a\", \"context\": {\"a\": 5}}", "{\"success\":false", "\"Invalid context\"}]}");
+	test_server("{\"id\": 2, \"code\": \"1\", \"context\": {\"b\": {\"t\": 5, \"v\": [{\"t\": 3, \"v\": \"x\"}]}}}", "{\"id\":2,\"success\":false", "\"Invalid context\"}]}");
+	test_server("{\"code\": \"let s = 'a\\\"b' s\"}", "{\"success\":true", "\"res\":\"'a\\\"b'\"}");
+	test_server("{\"code\": \"a + 1\", \"context\": {\"a\": {\"t\": 3, \"v\": 41}, \"b\": {\"t\": 5, \"v\": [{\"t\": 4, \"v\": \"x\\\"y\"}]}}}", "{\"success\":true", "\"b\":{\"t\":5,\"v\":[{\"t\":4,\"v\":\"x\\\"y\"}]}},\"res\":\"42\"}");
+	test_context({"var a = [1, 2, 3]", "a.push(4)", "a"}, "[1, 2, 3, 4]");
+	test_context({"var r = [1.5, 2.5]", "r.push(3)", "r"}, "[1.5, 2.5, 3]");
+	test_context({"var a = [] for (let i = 0; i < 3; i++) { a.push(i) }", "a"}, "[0, 1, 2]");
+	test_context({"var o = {x: 'hello'}", "var s = o.x + ' world'", "var l = [s, [1, 2], o, true, null]", "l"}, "['hello world', [1, 2], {x: 'hello'}, true, null]");
+	test("let a = [] for (let i = 0; i < 1000; i++) { a.push('hello') } a.size()", "1000");
+
 /*
 	test("3 ~ x -> x ^ x", "27");
 	test("[1, 2, 3] ~ x -> x + 4", "[1, 2, 3, 4]");
@@ -497,14 +640,8 @@ void Test::tests() {
 
 	/*
 	[1, 2, 3] ~~= (x -> x * 5 + 2)
-	[1, 2, 3] ~+= 1   =>   [2, 3, 4]
-	[1, 2, 3] ~*= 5
 	[1, 2, 3] ~= (x -> x * 5)
 
-	var dist = [...]
-	dist ~*= 5
-	var newdist = dist ~* 5
-
 
 	var a
 	;[1, 2, 3].map(...)
@@ -539,4 +676,234 @@ void Test::test(string code, string expected) {
 	}
 }
 
+/*
+ * Runs the code several times in several threads, each one with its own VM
+ */
+void Test::test_threads(string code, string expected) {
+
+	total++;
+
+	const int THREADS = 4;
+	vector<string> results(THREADS);
+	vector<thread> threads;
+	for (int t = 0; t < THREADS; ++t) {
+		threads.push_back(thread([&code, &expected, &results, t]() {
+			VM vm;
+			// Keeps the first wrong result
+			for (int i = 0; i < 20; ++i) {
+				string res = vm.execute(code, "{}", ExecMode::TEST);
+				if (i == 0 or results[t] == expected) results[t] = res;
+			}
+		}));
+	}
+	for (thread& t : threads) {
+		t.join();
+	}
+
+	for (const string& res : results) {
+		if (res != expected) {
+			cout << "FAUX : " << code << "  =/=>  " << expected << "  got  " << res << " (threads)" << endl;
+			return;
+		}
+	}
+	cout << "OK   : " << code << "  ===>  " << expected << " (threads)" << endl;
+	success++;
+}
+
+/*
+ * Executes a batch of jobs, some of them being the same program in other
+ * contexts : their results must be in the order of the jobs
+ */
+void Test::test_batch(int count, unsigned threads) {
+
+	total++;
+
+	vector<Job> jobs(count);
+	for (int i = 0; i < count; ++i) {
+		if (i % 2) {
+			jobs[i].code = "a * 2";
+			jobs[i].context = "{\"a\":{\"t\":3,\"v\":" + to_string(i) + "}}";
+		} else {
+			jobs[i].code = to_string(i) + " * 2";
+		}
+	}
+	vector<string> results = vm.execute_batch(jobs, threads);
+
+	for (int i = 0; i < count; ++i) {
+		string expected = ",\"res\":\"" + to_string(i * 2) + "\"}";
+		if (results[i].size() < expected.size() or results[i].substr(results[i].size() - expected.size()) != expected) {
+			cout << "FAUX : batch of " << count << " jobs  =/=>  job " << i << " got " << results[i] << endl;
+			return;
+		}
+	}
+	cout << "OK   : batch of " << count << " jobs" << endl;
+	success++;
+}
+
+/*
+ * Executes the code precompiled in a .lsc file, twice. The file changed is
+ * not loaded : a changed byte is found by the digest, and a token type out of
+ * range is found even with the digest of the changed file.
+ */
+void Test::test_file(string code, string expected) {
+
+	total++;
+
+	string path = "/tmp/leekscript_test.lsc";
+	string results[2];
+	for (int i = 0; i < 2; ++i) {
+		results[i] = TokenFile::save(path, code) ? vm.execute_file(path, "{}", ExecMode::TEST) : "<not saved>";
+	}
+
+	ifstream in(path, ios::binary);
+	string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	in.close();
+
+	// The first token type follows the magic, the digest and the tokens count
+	string changed = content;
+	changed.back() ^= 1;
+	string forged = content;
+	uint32_t type = TOKEN_TYPES;
+	forged.replace(40, 4, (const char*) &type, 4);
+	forged.replace(4, 32, sha256(forged.substr(36)));
+
+	ostream* vm_output = vm.output;
+	ostringstream out;
+	vm.output = &out;
+	int rejected = 0;
+	for (const string& file : {changed, forged}) {
+		ofstream(path, ios::binary) << file;
+		out.str("");
+		vm.execute_file(path, "{}", ExecMode::TEST);
+		rejected += out.str().compare(0, 10, "Can't load") == 0;
+	}
+	vm.output = vm_output;
+	remove(path.c_str());
+
+	if (results[0] != expected or results[1] != expected or rejected != 2) {
+		cout << "FAUX : " << code << "  =/=>  " << expected << "  got  " << results[0] << " / " << results[1] << " (file, " << rejected << " rejected)" << endl;
+		return;
+	}
+	cout << "OK   : " << code << "  ===>  " << expected << " (file)" << endl;
+	success++;
+}
+
+/*
+ * Executes the code and the reference code, computing the same result : the
+ * memory peak of the code must not exceed the one of the reference
+ */
+void Test::test_memory(string code, string reference) {
+
+	total++;
+
+	long memory[2];
+	string results[2];
+	string codes[2] = {code, reference};
+	for (int i = 0; i < 2; ++i) {
+		Job job;
+		job.code = codes[i];
+		string answer = vm.execute_job(job);
+		size_t m = answer.find("\"memory\":");
+		memory[i] = m == string::npos ? -1 : stol(answer.substr(m + 9));
+		size_t r = answer.rfind("\"res\":");
+		results[i] = r == string::npos ? answer : answer.substr(r);
+	}
+
+	if (memory[0] < 0 or results[0] != results[1] or memory[0] > memory[1]) {
+		cout << "FAUX : " << code << "  =/=>  " << memory[1] << " bytes  got  " << memory[0] << " bytes" << endl;
+		return;
+	}
+	cout << "OK   : " << code << "  ===>  " << memory[1] << " bytes" << endl;
+	success++;
+}
+
+/*
+ * Executes the codes twice, one after the other, in a VM keeping less
+ * programs : the least recently used ones are compiled again
+ */
+void Test::test_programs_cap(vector<pair<string, string>> tests, size_t cap) {
+
+	total++;
+
+	VM vm;
+	vm.programs_cap = cap;
+	for (int i = 0; i < 2; ++i) {
+		for (auto& test : tests) {
+			string res = vm.execute(test.first, "{}", ExecMode::TEST);
+			if (res != test.second or vm.programs.size() > cap) {
+				cout << "FAUX : " << test.first << "  =/=>  " << test.second << "  got  " << res << " (" << vm.programs.size() << " programs)" << endl;
+				return;
+			}
+		}
+	}
+	cout << "OK   : " << tests.size() << " programs  ===>  " << cap << " kept" << endl;
+	success++;
+}
+
+/*
+ * Sends a job to a server, its answer must start and end as expected
+ * (the times in the middle change)
+ */
+void Test::test_server(string job, string start, string end, size_t max_line) {
+
+	total++;
+
+	Server server(vm);
+	server.max_line = max_line;
+	istringstream in(job + "\n" + job + "\n");
+	ostringstream out;
+	server.serve(in, out);
+
+	string answer;
+	istringstream lines(out.str());
+	for (int i = 0; i < 2; ++i) {
+		getline(lines, answer);
+		if (answer.compare(0, start.size(), start) != 0 or answer.size() < end.size()
+			or answer.compare(answer.size() - end.size(), end.size(), end) != 0) {
+			cout << "FAUX : " << job << "  =/=>  " << start << "..." << end << "  got  " << answer << endl;
+			return;
+		}
+	}
+	cout << "OK   : " << job << "  ===>  " << start << "..." << end << endl;
+	success++;
+}
+
+/*
+ * Executes the codes one after the other in a live context : the last one
+ * is also executed in a context loaded from a snapshot of the previous ones,
+ * and must print the same result in both
+ */
+void Test::test_context(vector<string> codes, string expected) {
+
+	total++;
+
+	ostream* vm_output = vm.output;
+	ostringstream out;
+	vm.output = &out;
+
+	Context context;
+	for (size_t i = 0; i + 1 < codes.size(); ++i) {
+		vm.execute(codes[i], context, ExecMode::TOP_LEVEL);
+	}
+	stringstream snapshot;
+	Context loaded;
+	bool restored = context.save(snapshot) and loaded.load(snapshot);
+
+	string results[2];
+	Context* contexts[2] = {&context, &loaded};
+	for (int i = 0; i < 2; ++i) {
+		out.str("");
+		vm.execute(codes.back(), *contexts[i], ExecMode::TOP_LEVEL);
+		results[i] = out.str().substr(0, out.str().find('\n'));
+	}
+	vm.output = vm_output;
+
+	if (!restored or results[0] != expected or results[1] != expected) {
+		cout << "FAUX : " << codes.back() << "  =/=>  " << expected << "  got  " << results[0] << " / " << results[1] << " (context)" << endl;
+		return;
+	}
+	cout << "OK   : " << codes.back() << "  ===>  " << expected << " (context)" << endl;
+	success++;
+}
+
 Test::~Test() {}
@@ -3,7 +3,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include "../vm/VM.hpp"
+#include "../vm/Server.hpp"
 
 class Test {
 
@@ -21,6 +23,13 @@ public:
 	void header(std::string);
 
 	void test(std::string code, std::string result);
+	void test_threads(std::string code, std::string result);
+	void test_batch(int count, unsigned threads);
+	void test_server(std::string job, std::string start, std::string end, size_t max_line = Server::DEFAULT_MAX_LINE);
+	void test_context(std::vector<std::string> codes, std::string result);
+	void test_file(std::string code, std::string result);
+	void test_memory(std::string code, std::string reference);
+	void test_programs_cap(std::vector<std::pair<std::string, std::string>> tests, size_t cap);
 };
 
 #endif
@@ -0,0 +1,115 @@
+#include "Arena.hpp"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+Arena::Arena(size_t cap) : current(nullptr), left(0), total(0), reserved_size(0), used_size(0), peak_size(0), cap(cap) {
+	for (auto& list : free_lists) {
+		list = nullptr;
+	}
+}
+
+Arena::~Arena() {
+	for (Chunk& chunk : chunks) {
+		std::free(chunk.start);
+	}
+}
+
+void Arena::new_chunk(size_t min_size) {
+	size_t size = min_size > CHUNK_SIZE ? min_size : CHUNK_SIZE;
+	char* start = (char*) malloc(size);
+	if (start == nullptr) {
+		throw bad_alloc();
+	}
+	chunks.push_back({start, size});
+	current = start;
+	left = size;
+	reserved_size += size;
+}
+
+void* Arena::allocate(size_t size) {
+
+	size = (size + ALIGN - 1) & ~(ALIGN - 1);
+
+	account(size);
+	if (size <= MAX_RECYCLED_SIZE) {
+		FreeBlock*& list = free_lists[size / ALIGN];
+		if (list != nullptr) {
+			FreeBlock* block = list;
+			list = block->next;
+			return block;
+		}
+	}
+	if (size > left) {
+		new_chunk(size);
+	}
+	void* block = current;
+	current += size;
+	left -= size;
+	total += size;
+	return block;
+}
+
+void Arena::free(void* block, size_t size) {
+
+	size = (size + ALIGN - 1) & ~(ALIGN - 1);
+	release(size);
+
+	// Big blocks are only released with the arena
+	if (size <= MAX_RECYCLED_SIZE) {
+		FreeBlock* b = (FreeBlock*) block;
+		b->next = free_lists[size / ALIGN];
+		free_lists[size / ALIGN] = b;
+	}
+}
+
+/*
+ * The memory is accounted even beyond the cap : false when it's reached
+ */
+bool Arena::account(size_t size) {
+	used_size += size;
+	if (used_size > peak_size) {
+		peak_size = used_size;
+	}
+	return !over_cap();
+}
+
+void Arena::release(size_t size) {
+	// Memory allocated before the execution may be released during it
+	used_size = size < used_size ? used_size - size : 0;
+}
+
+void Arena::set_cap(size_t cap) {
+	this->cap = cap;
+}
+
+bool Arena::over_cap() const {
+	return cap != 0 and used_size > cap;
+}
+
+bool Arena::contains(const void* block) const {
+	// Most recent chunks first : recent values are the most likely to be freed
+	for (auto c = chunks.rbegin(); c != chunks.rend(); ++c) {
+		if (block >= c->start and block < c->start + c->size) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t Arena::allocated() const {
+	return total;
+}
+
+size_t Arena::reserved() const {
+	return reserved_size;
+}
+
+size_t Arena::used() const {
+	return used_size;
+}
+
+size_t Arena::peak() const {
+	return peak_size;
+}
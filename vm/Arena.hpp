@@ -0,0 +1,68 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Bump allocator owned by an execution. Values allocated in it are
+ * released all at once when the arena is destroyed. Blocks freed during
+ * the execution are kept in free lists (one per size class) to be reused.
+ * The arena also accounts the memory used by the execution : its live
+ * blocks plus the memory reported by the values (buffers of the containers).
+ * It can be capped : the allocations beyond the cap succeed, but report it,
+ * the execution is then stopped by the VM at its next operations check.
+ */
+class Arena {
+public:
+
+	static const size_t CHUNK_SIZE = 64 * 1024;
+	static const size_t ALIGN = 16;
+	static const size_t MAX_RECYCLED_SIZE = 256;
+
+	Arena(size_t cap = 0);
+	virtual ~Arena();
+
+	void* allocate(size_t size);
+	void free(void* block, size_t size);
+	bool contains(const void* block) const;
+
+	bool account(size_t size);
+	void release(size_t size);
+	void set_cap(size_t cap);
+	bool over_cap() const;
+
+	size_t allocated() const;
+	size_t reserved() const;
+	size_t used() const;
+	size_t peak() const;
+
+private:
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct Chunk {
+		char* start;
+		size_t size;
+	};
+
+	std::vector<Chunk> chunks;
+	char* current;
+	size_t left;
+	size_t total;
+	size_t reserved_size;
+	size_t used_size;
+	size_t peak_size;
+	// Maximum memory used, 0 for no limit
+	size_t cap;
+	FreeBlock* free_lists[MAX_RECYCLED_SIZE / ALIGN + 1];
+
+	Arena(const Arena&) = delete;
+	Arena& operator = (const Arena&) = delete;
+
+	void new_chunk(size_t min_size);
+};
+
+#endif
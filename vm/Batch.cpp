@@ -0,0 +1,190 @@
+#include "VM.hpp"
+#include "Context.hpp"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include "../lib/gason.h"
+
+using namespace std;
+
+/*
+ * Job written as a JSON object : {"code": "...", "context": {...}, "id": ...,
+ * "limits": {"memory": bytes, "operations": count}}, the context being in the
+ * format of the contexts of the command mode
+ */
+bool Job::parse(string line, Job& job) {
+
+	char* endptr;
+	JsonValue value;
+	JsonAllocator allocator;
+	if (jsonParse((char*) line.c_str(), &endptr, &value, allocator) != JSON_OK or value.getTag() != JSON_OBJECT) {
+		return false;
+	}
+	bool has_code = false;
+	for (auto i : value) {
+		string key = i->key;
+		JsonTag tag = i->value.getTag();
+		if (key == "code" and tag == JSON_STRING) {
+			job.code = i->value.toString();
+			has_code = true;
+		} else if (key == "context" and tag == JSON_OBJECT) {
+			ostringstream context;
+			Context::json(context, i->value);
+			job.context = context.str();
+			for (auto var : i->value) {
+				if (!Context::valid(var->value)) job.valid_context = false;
+			}
+		} else if (key == "id" and tag == JSON_NUMBER) {
+			// The integral ids are written entirely, the others with the digits
+			// needed to read them back
+			double id = i->value.toNumber();
+			ostringstream oss;
+			if (id == floor(id) and fabs(id) < 1e15) {
+				oss << (long long) id;
+			} else {
+				oss << setprecision(15) << id;
+				if (stod(oss.str()) != id) {
+					oss.str("");
+					oss << setprecision(17) << id;
+				}
+			}
+			job.id = oss.str();
+		} else if (key == "id" and tag == JSON_STRING) {
+			ostringstream oss;
+			LSValue::json_string(oss, i->value.toString());
+			job.id = oss.str();
+		} else if (key == "limits" and tag == JSON_OBJECT) {
+			for (auto l : i->value) {
+				if (l->value.getTag() != JSON_NUMBER) continue;
+				if (string(l->key) == "memory") job.heap_cap = l->value.toNumber();
+				if (string(l->key) == "operations") job.operations_limit = l->value.toNumber();
+			}
+		}
+	}
+	return has_code;
+}
+
+/*
+ * Lowest of the limit of a VM and the one of a job, 0 being no limit for
+ * the VM and its limit for the job
+ */
+template <class T>
+static T job_limit(T vm_limit, long limit) {
+	if (limit <= 0) return vm_limit;
+	if (vm_limit == 0) return limit;
+	return min(vm_limit, (T) limit);
+}
+
+/*
+ * Executes the job in the command mode, and returns its JSON result
+ */
+string VM::execute_job(const Job& job) {
+
+	string result;
+	if (job.valid_context) {
+		size_t vm_heap_cap = heap_cap;
+		long vm_operations_limit = operations_limit;
+		ostream* vm_output = output;
+		heap_cap = job_limit(heap_cap, job.heap_cap);
+		operations_limit = job_limit(operations_limit, job.operations_limit);
+
+		ostringstream oss;
+		output = &oss;
+		execute(job.code, job.context, ExecMode::COMMAND_JSON);
+
+		heap_cap = vm_heap_cap;
+		operations_limit = vm_operations_limit;
+		output = vm_output;
+
+		result = oss.str();
+		if (!result.empty() and result.back() == '\n') {
+			result.pop_back();
+		}
+	} else {
+		result = "{\"success\":false,\"errors\":[{\"message\":\"Invalid context\"}]}";
+	}
+	if (!job.id.empty() and result.size() > 1) {
+		result = "{\"id\":" + job.id + "," + result.substr(1);
+	}
+	return result;
+}
+
+/*
+ * Jobs of a worker : it takes them from the front, the workers with no job
+ * left steal them from the back
+ */
+class WorkQueue {
+public:
+	mutex lock;
+	deque<size_t> jobs;
+
+	bool pop(size_t& job) {
+		lock_guard<mutex> guard(lock);
+		if (jobs.empty()) return false;
+		job = jobs.front();
+		jobs.pop_front();
+		return true;
+	}
+
+	bool steal(size_t& job) {
+		lock_guard<mutex> guard(lock);
+		if (jobs.empty()) return false;
+		job = jobs.back();
+		jobs.pop_back();
+		return true;
+	}
+};
+
+vector<string> VM::execute_batch(const vector<Job>& jobs, unsigned threads) {
+
+	if (threads == 0) {
+		threads = max(1u, thread::hardware_concurrency());
+	}
+	threads = min(threads, (unsigned) max((size_t) 1, jobs.size()));
+
+	while (workers.size() < threads) {
+		workers.push_back(unique_ptr<VM>(new VM()));
+	}
+
+	// Contiguous ranges of jobs : the same programs tend to be in the same cache
+	vector<WorkQueue> queues(threads);
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		queues[i * threads / jobs.size()].jobs.push_back(i);
+	}
+
+	vector<string> results(jobs.size());
+
+	auto work = [&](unsigned w) {
+
+		VM& vm = *workers[w];
+		vm.heap_cap = heap_cap;
+		vm.operations_limit = operations_limit;
+
+		size_t job;
+		while (true) {
+			if (!queues[w].pop(job)) {
+				// No job is added during the batch : it ends when nothing can be stolen
+				bool stolen = false;
+				for (unsigned v = 1; v < threads and !stolen; ++v) {
+					stolen = queues[(w + v) % threads].steal(job);
+				}
+				if (!stolen) break;
+			}
+			results[job] = vm.execute_job(jobs[job]);
+		}
+	};
+
+	vector<thread> pool;
+	for (unsigned w = 1; w < threads; ++w) {
+		pool.push_back(thread(work, w));
+	}
+	work(0);
+	for (thread& t : pool) {
+		t.join();
+	}
+	return results;
+}
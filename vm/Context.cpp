@@ -2,6 +2,7 @@
 #include <sstream>
 #include <string.h>
 #include <vector>
+#include <cstdint>
 #include "VM.hpp"
 #include "../lib/gason.h"
 using namespace std;
@@ -18,19 +19,440 @@ std::vector<std::string> split(const std::string &s, string delim) {
 	return v;
 }
 
-Context::Context(std::string ctx) {
+const char Context::MAGIC[4] = {'L', 'S', 'X', '1'};
+
+/*
+ * Makes the values created or released live in the arena of the context
+ */
+class ContextArena {
+public:
+	Arena* previous;
+	ContextArena(Arena* arena) : previous(LSValue::arena) {
+		LSValue::arena = arena;
+	}
+	~ContextArena() {
+		LSValue::arena = previous;
+	}
+};
+
+Context::Context() : arena(new Arena()) {}
+
+Context::Context(std::string ctx) : source(ctx) {
 
 	char *endptr;
 	JsonValue value;
-	JsonAllocator allocator;
-	jsonParse((char*) ctx.c_str(), &endptr, &value, allocator);
-
+	if (jsonParse(&source[0], &endptr, &value, allocator) != JSON_OK or value.getTag() != JSON_OBJECT) {
+		return;
+	}
 	for (auto i : value) {
-		string name =  i->key;
-		JsonValue var = i->value;
-		vars.insert(pair<string, LSValue*>(name, LSValue::parse(var)));
+		json_vars.insert(pair<string, JsonValue>(i->key, i->value));
+	}
+}
+
+Context::~Context() {
+	ContextArena context_arena(arena != nullptr ? arena.get() : LSValue::arena);
+	for (auto var : vars) {
+		LSValue::delete_ref(var.second);
+	}
+}
+
+/*
+ * Type of a value of a JSON context, known from its type field {"t": typeID}
+ */
+static RawType json_type(const JsonValue& value) {
+	if (value.getTag() != JSON_OBJECT or value.toNode() == nullptr) {
+		return RawType::NULLL;
+	}
+	switch ((int) value.toNode()->value.toNumber()) {
+		case 2: return RawType::BOOLEAN;
+		case 3: return RawType::INTEGER;
+		case 4: return RawType::STRING;
+		case 5: return RawType::ARRAY;
+		case 6: return RawType::OBJECT;
+		case 7: return RawType::FUNCTION;
+		case 8: return RawType::CLASS;
+	}
+	return RawType::NULLL;
+}
+
+map<string, RawType> Context::types() const {
+	map<string, RawType> types;
+	for (auto var : vars) {
+		types.insert({var.first, var.second->getRawType()});
+	}
+	for (auto var : json_vars) {
+		types.insert({var.first, json_type(var.second)});
+	}
+	return types;
+}
+
+/*
+ * Value of a variable, materialized from the JSON the first time it's used
+ */
+LSValue* Context::get(const string& name) {
+	auto var = vars.find(name);
+	if (var != vars.end()) {
+		return var->second;
+	}
+	auto json_var = json_vars.find(name);
+	if (json_var == json_vars.end()) {
+		return LSNull::null_var;
+	}
+	LSValue* value = LSValue::parse(json_var->second);
+	LSValue::inc_refs(value);
+	json_vars.erase(json_var);
+	vars.insert({name, value});
+	return value;
+}
+
+/*
+ * Sets the variables to the globals of a program, adopting their values.
+ * The variables the program didn't use are kept.
+ */
+void Context::update(const map<string, LSValue*>& globals) {
+	for (auto g : globals) {
+		LSValue::inc_refs(g.second);
+		auto var = vars.find(g.first);
+		if (var != vars.end()) {
+			LSValue::delete_ref(var->second);
+			var->second = g.second;
+		} else {
+			vars.insert(g);
+			json_vars.erase(g.first);
+		}
+	}
+}
+
+/*
+ * Removes all the variables : a live context gets a new arena, the memory
+ * leaked by a stopped execution is released with the previous one
+ */
+void Context::clear() {
+	{
+		ContextArena context_arena(arena != nullptr ? arena.get() : LSValue::arena);
+		for (auto var : vars) {
+			LSValue::delete_ref(var.second);
+		}
+	}
+	vars.clear();
+	json_vars.clear();
+	if (arena != nullptr) {
+		arena.reset(new Arena());
+	}
+}
+
+/*
+ * The variables by name, the values or their JSON
+ */
+ostream& Context::json(ostream& os) const {
+	os << "{";
+	auto var = vars.begin();
+	auto json_var = json_vars.begin();
+	while (var != vars.end() or json_var != json_vars.end()) {
+		if (var != vars.begin() or json_var != json_vars.begin()) os << ",";
+		if (json_var == json_vars.end() or (var != vars.end() and var->first < json_var->first)) {
+			LSValue::json_string(os, var->first) << ":";
+			var->second->to_json(os);
+			++var;
+		} else {
+			LSValue::json_string(os, json_var->first) << ":";
+			json(os, json_var->second);
+			++json_var;
+		}
+	}
+	return os << "}";
+}
+
+/*
+ * Writes a parsed JSON value back
+ */
+ostream& Context::json(ostream& os, const JsonValue& value) {
+	switch (value.getTag()) {
+		case JSON_NUMBER: return LSNumber(value.toNumber()).json(os);
+		case JSON_STRING: return LSValue::json_string(os, value.toString());
+		case JSON_TRUE: return os << "true";
+		case JSON_FALSE: return os << "false";
+		case JSON_NULL: return os << "null";
+		case JSON_ARRAY: {
+			os << "[";
+			for (auto i : value) {
+				if (i != value.toNode()) os << ",";
+				json(os, i->value);
+			}
+			return os << "]";
+		}
+		case JSON_OBJECT: {
+			os << "{";
+			for (auto i : value) {
+				if (i != value.toNode()) os << ",";
+				LSValue::json_string(os, i->key) << ":";
+				json(os, i->value);
+			}
+			return os << "}";
+		}
+	}
+	return os;
+}
+
+/*
+ * A value of a JSON context is {"t": typeID, "v": content}, the content of
+ * the arrays and the objects being values too
+ */
+bool Context::valid(const JsonValue& value) {
+	if (value.getTag() != JSON_OBJECT or value.toNode() == nullptr) {
+		return false;
+	}
+	JsonNode* t = value.toNode();
+	JsonNode* v = t->next;
+	if (string(t->key) != "t" or t->value.getTag() != JSON_NUMBER or v == nullptr or string(v->key) != "v") {
+		return false;
+	}
+	JsonTag tag = v->value.getTag();
+	switch ((int) t->value.toNumber()) {
+		case 3: return tag == JSON_NUMBER;
+		case 4: return tag == JSON_STRING;
+		case 5:
+		case 6: {
+			if (tag != (t->value.toNumber() == 5 ? JSON_ARRAY : JSON_OBJECT)) {
+				return false;
+			}
+			for (auto i : v->value) {
+				if (!valid(i->value)) return false;
+			}
+			return true;
+		}
 	}
+	return true;
 }
 
-Context::~Context() {}
+string Context::json() const {
+	ostringstream oss;
+	json(oss);
+	return oss.str();
+}
+
+template <class T>
+static void write(ostream& out, T value) {
+	out.write((const char*) &value, sizeof(value));
+}
+
+template <class T>
+static bool read(istream& in, T& value) {
+	return (bool) in.read((char*) &value, sizeof(value));
+}
+
+static void write_string(ostream& out, const string& s) {
+	write<uint32_t>(out, s.size());
+	out.write(s.data(), s.size());
+}
+
+static bool read_string(istream& in, string& s) {
+	uint32_t size;
+	if (!read(in, size)) {
+		return false;
+	}
+	s.resize(size);
+	return size == 0 or (bool) in.read(&s[0], size);
+}
+
+// Layouts of the arrays in a snapshot
+enum class ArrayKind : uint8_t {
+	LIST, ASSOCIATIVE, INTEGERS, REALS
+};
+
+/*
+ * A value is its type (see LSValue::typeID) followed by its content. The
+ * functions and the classes belong to a compiled program : they're written
+ * as null.
+ */
+void Context::write_value(ostream& out, const LSValue* value) {
+
+	int type = value->typeID();
+	if (type == 7 or type == 8) {
+		type = 1;
+	}
+	write<uint8_t>(out, type);
+
+	if (type == 2) {
+		write<uint8_t>(out, ((const LSBoolean*) value)->value);
+	} else if (type == 3) {
+		write<double>(out, ((const LSNumber*) value)->value);
+	} else if (type == 4) {
+		write_string(out, ((const LSString*) value)->value);
+	} else if (type == 5) {
+		const LSArray* array = (const LSArray*) value;
+		if (array->unboxed == RawType::INTEGER) {
+			write(out, ArrayKind::INTEGERS);
+			write<uint32_t>(out, array->ints.size());
+			out.write((const char*) array->ints.data(), array->ints.size() * sizeof(int));
+		} else if (array->unboxed == RawType::FLOAT) {
+			write(out, ArrayKind::REALS);
+			write<uint32_t>(out, array->reals.size());
+			out.write((const char*) array->reals.data(), array->reals.size() * sizeof(double));
+		} else if (array->associative) {
+			write(out, ArrayKind::ASSOCIATIVE);
+			write<uint32_t>(out, array->entries.size());
+			for (auto e : array->entries) {
+				write_value(out, e.first);
+				write_value(out, e.second);
+			}
+		} else {
+			write(out, ArrayKind::LIST);
+			write<uint32_t>(out, array->list.size());
+			for (auto v : array->list) {
+				write_value(out, v);
+			}
+		}
+	} else if (type == 6) {
+		const LSObject* object = (const LSObject*) value;
+		write<uint32_t>(out, object->values.size());
+		for (auto v : object->values) {
+			write_string(out, v.first);
+			write_value(out, v.second);
+		}
+	}
+}
+
+LSArray* Context::read_array(istream& in) {
+
+	ArrayKind kind;
+	uint32_t size;
+	if (!read(in, kind) or !read(in, size)) {
+		return nullptr;
+	}
+	LSArray* array;
+	if (kind == ArrayKind::INTEGERS or kind == ArrayKind::REALS) {
+		array = new LSArray(kind == ArrayKind::INTEGERS ? RawType::INTEGER : RawType::FLOAT);
+		for (uint32_t i = 0; i < size; ++i) {
+			bool ok;
+			if (kind == ArrayKind::INTEGERS) {
+				int n;
+				ok = read(in, n);
+				if (ok) array->ints.push_back(n);
+			} else {
+				double n;
+				ok = read(in, n);
+				if (ok) array->reals.push_back(n);
+			}
+			if (!ok) {
+				delete array;
+				return nullptr;
+			}
+			array->index++;
+		}
+		return array;
+	}
+	array = new LSArray();
+	for (uint32_t i = 0; i < size; ++i) {
+		LSValue* key = kind == ArrayKind::ASSOCIATIVE ? read_value(in) : nullptr;
+		LSValue* value = kind != ArrayKind::ASSOCIATIVE or key != nullptr ? read_value(in) : nullptr;
+		if (value == nullptr) {
+			if (key != nullptr) LSValue::delete_temporary(key);
+			delete array;
+			return nullptr;
+		}
+		if (kind == ArrayKind::ASSOCIATIVE) {
+			array->pushKeyNoClone(key, value);
+		} else {
+			array->pushNoClone(value);
+		}
+	}
+	return array;
+}
+
+LSValue* Context::read_value(istream& in) {
+
+	uint8_t type;
+	if (!read(in, type)) {
+		return nullptr;
+	}
+	switch (type) {
+		case 1: return LSNull::null_var;
+		case 2: {
+			uint8_t b;
+			return read(in, b) ? LSBoolean::get(b) : nullptr;
+		}
+		case 3: {
+			double n;
+			return read(in, n) ? new LSNumber(n) : nullptr;
+		}
+		case 4: {
+			string s;
+			return read_string(in, s) ? new LSString(s) : nullptr;
+		}
+		case 5: return read_array(in);
+		case 6: {
+			uint32_t size;
+			if (!read(in, size)) {
+				return nullptr;
+			}
+			LSObject* object = new LSObject();
+			for (uint32_t i = 0; i < size; ++i) {
+				string name;
+				LSValue* value = read_string(in, name) ? read_value(in) : nullptr;
+				if (value == nullptr) {
+					delete object;
+					return nullptr;
+				}
+				object->addField(name, value);
+			}
+			return object;
+		}
+	}
+	return nullptr;
+}
+
+bool Context::save(ostream& out) const {
+	out.write(MAGIC, sizeof(MAGIC));
+	write<uint32_t>(out, vars.size() + json_vars.size());
+	for (auto var : vars) {
+		write_string(out, var.first);
+		write_value(out, var.second);
+	}
+	for (auto var : json_vars) {
+		write_string(out, var.first);
+		JsonValue json = var.second;
+		LSValue* value = LSValue::parse(json);
+		write_value(out, value);
+		LSValue::delete_temporary(value);
+	}
+	return out.good();
+}
+
+/*
+ * Replaces the variables by the ones of a snapshot : the context is left
+ * unchanged if it's not valid
+ */
+bool Context::load(istream& in) {
+
+	if (arena == nullptr) {
+		arena.reset(new Arena());
+	}
+	ContextArena context_arena(arena.get());
+
+	char magic[sizeof(MAGIC)];
+	uint32_t count;
+	if (!in.read(magic, sizeof(magic)) or memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 or !read(in, count)) {
+		return false;
+	}
+	map<string, LSValue*> loaded;
+	bool valid = true;
+	for (uint32_t i = 0; i < count and valid; ++i) {
+		string name;
+		LSValue* value = read_string(in, name) ? read_value(in) : nullptr;
+		if (value == nullptr) {
+			valid = false;
+		} else {
+			loaded[name] = value;
+		}
+	}
+	if (valid) {
+		update(loaded);
+	} else {
+		for (auto var : loaded) {
+			LSValue::delete_temporary(var.second);
+		}
+	}
+	return valid;
+}
 
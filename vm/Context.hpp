@@ -2,16 +2,72 @@
 #define CONTEXT_HPP
 
 #include <map>
+#include <memory>
 #include <string>
+#include <iostream>
 #include "LSValue.hpp"
+#include "Arena.hpp"
+#include "Type.hpp"
+#include "../lib/gason.h"
+class LSArray;
 
+/*
+ * Global variables given to a top level program, and updated with its
+ * globals when it ends.
+ * A context read from JSON only lives for one execution. Its variables stay
+ * in the parsed JSON tree until a program uses them : the others are written
+ * back as they were, without being materialized. A live context
+ * (built empty, or loaded from a snapshot) keeps its values in its own
+ * arena from an execution to another : nothing is parsed nor serialized
+ * between them, whatever the size of the state. When an execution is
+ * stopped, the context is emptied : its values could be left half changed,
+ * and the memory of the execution is got back with its arena.
+ */
 class Context {
 public:
 
+	static const char MAGIC[4];
+
+	std::map<std::string, LSValue*> vars;
+
+	// Variables of a JSON context not used yet, in the parsed tree of the JSON
+	std::map<std::string, JsonValue> json_vars;
+
+	// Arena of the values of a live context, null for a JSON context
+	std::unique_ptr<Arena> arena;
+
+	Context();
 	Context(std::string ctx);
 	virtual ~Context();
 
-	std::map<std::string, LSValue*> vars;
+	std::map<std::string, RawType> types() const;
+	LSValue* get(const std::string& name);
+	void update(const std::map<std::string, LSValue*>& globals);
+	void clear();
+	std::ostream& json(std::ostream& os) const;
+	std::string json() const;
+
+	static std::ostream& json(std::ostream& os, const JsonValue& value);
+	static bool valid(const JsonValue& value);
+
+	/*
+	 * Snapshot of a live context, in a compact binary format : the values
+	 * are written with their type and their raw content
+	 */
+	bool save(std::ostream& out) const;
+	bool load(std::istream& in);
+
+private:
+	// Text of a JSON context, parsed in place, and the nodes of its tree
+	std::string source;
+	JsonAllocator allocator;
+
+	static void write_value(std::ostream& out, const LSValue* value);
+	static LSValue* read_value(std::istream& in);
+	static LSArray* read_array(std::istream& in);
+
+	Context(const Context&) = delete;
+	Context& operator = (const Context&) = delete;
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef LSALLOCATOR_HPP
+#define LSALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include "LSValue.hpp"
+
+/*
+ * Allocator of the containers inside the values : their buffers are on the
+ * heap, but accounted in the memory used by the running execution
+ */
+template <class T>
+class LSAllocator {
+public:
+
+	typedef T value_type;
+
+	LSAllocator() {}
+	template <class U> LSAllocator(const LSAllocator<U>&) {}
+
+	T* allocate(size_t n) {
+		LSValue::account(n * sizeof(T));
+		return (T*) ::operator new(n * sizeof(T));
+	}
+
+	void deallocate(T* block, size_t n) {
+		LSValue::release(n * sizeof(T));
+		::operator delete(block);
+	}
+};
+
+template <class T, class U>
+bool operator == (const LSAllocator<T>&, const LSAllocator<U>&) {
+	return true;
+}
+
+template <class T, class U>
+bool operator != (const LSAllocator<T>&, const LSAllocator<U>&) {
+	return false;
+}
+
+#endif
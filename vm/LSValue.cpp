@@ -1,10 +1,51 @@
 #include <iostream>
+#include <sstream>
+#include <cstdio>
 #include "LSValue.hpp"
 #include "value/LSNumber.hpp"
 #include "VM.hpp"
+#include "Arena.hpp"
 
 using namespace std;
 
+thread_local Arena* LSValue::arena = nullptr;
+
+void* LSValue::operator new(size_t size) {
+	if (arena != nullptr) {
+		void* block = arena->allocate(size);
+		// Heap cap of the execution reached : it's stopped if it's running
+		if (arena->over_cap() and VM::running != nullptr) {
+			VM::running->stop(ExecError::HEAP_CAP);
+		}
+		return block;
+	}
+	return ::operator new(size);
+}
+
+void LSValue::operator delete(void* block, size_t size) {
+	if (arena != nullptr and arena->contains(block)) {
+		arena->free(block, size);
+	} else {
+		::operator delete(block);
+	}
+}
+
+/*
+ * Called by the allocators of the containers, inside the standard library :
+ * the execution can only be stopped later
+ */
+void LSValue::account(size_t size) {
+	if (arena != nullptr and !arena->account(size) and VM::running != nullptr) {
+		VM::running->stop(ExecError::HEAP_CAP);
+	}
+}
+
+void LSValue::release(size_t size) {
+	if (arena != nullptr) {
+		arena->release(size);
+	}
+}
+
 std::ostream& operator << (std::ostream& os, LSValue& value) {
 	cout << "print LSValue" << endl;
 	value.print(os);
@@ -43,6 +84,43 @@ LSValue* LSValue::parse(JsonValue& json) {
 	return get_value(type, data);
 }
 
+ostream& LSValue::to_json(ostream& os) const {
+	os << "{\"t\":" << typeID() << ",\"v\":";
+	json(os);
+	return os << "}";
+}
+
 string LSValue::to_json() const {
-	return "{\"t\":" + to_string(typeID()) + ",\"v\":" + json() + "}";
+	ostringstream oss;
+	to_json(oss);
+	return oss.str();
+}
+
+/*
+ * A string in JSON, quoted, with its quotes, backslashes and control
+ * characters escaped
+ */
+ostream& LSValue::json_string(ostream& os, const string& s) {
+	os << '"';
+	size_t start = 0;
+	for (size_t i = 0; i < s.size(); ++i) {
+		unsigned char c = s[i];
+		if (c != '"' and c != '\\' and c >= 0x20) continue;
+		os.write(s.data() + start, i - start);
+		start = i + 1;
+		switch (c) {
+			case '"': os << "\\\""; break;
+			case '\\': os << "\\\\"; break;
+			case '\n': os << "\\n"; break;
+			case '\r': os << "\\r"; break;
+			case '\t': os << "\\t"; break;
+			default: {
+				char code[7];
+				snprintf(code, sizeof(code), "\\u%04x", c);
+				os << code;
+			}
+		}
+	}
+	os.write(s.data() + start, s.size() - start);
+	return os << '"';
 }
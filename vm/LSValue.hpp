@@ -17,10 +17,37 @@ class LSFunction;
 class LSObject;
 class LSClass;
 class Context;
+class Arena;
 
 class LSValue {
 public:
 
+	/*
+	 * Number of references (variables, containers) held on the value.
+	 * A value with no reference is a temporary, it can be deleted as soon
+	 * as the operation using it is done. Native values (constants, classes)
+	 * are shared by the whole VM and are never deleted : their references
+	 * aren't counted, so they can be read by several threads at once.
+	 */
+	int refs = 0;
+	bool native = false;
+
+	/*
+	 * Arena of the execution running in the thread : while it's set, the
+	 * values are allocated in it instead of the heap
+	 */
+	static thread_local Arena* arena;
+
+	static void* operator new(size_t size);
+	static void operator delete(void* block, size_t size);
+
+	/*
+	 * Memory allocated outside of the arena by the values (buffers of the
+	 * containers), accounted in the memory used by the execution
+	 */
+	static void account(size_t size);
+	static void release(size_t size);
+
 	virtual ~LSValue() = 0;
 
 	virtual bool isTrue() const = 0;
@@ -219,10 +246,19 @@ public:
 	virtual LSValue* abso() const = 0;
 
 	virtual std::ostream& print(std::ostream&) const = 0;
-	virtual std::string json() const = 0;
+	/*
+	 * JSON of the value, written in the stream as it goes. to_json() adds its
+	 * type : {"t": typeID, "v": json}, the format of the contexts.
+	 */
+	virtual std::ostream& json(std::ostream&) const = 0;
+	std::ostream& to_json(std::ostream&) const;
 	std::string to_json() const;
+	static std::ostream& json_string(std::ostream&, const std::string&);
 
 	virtual LSValue* clone() const = 0;
+	LSValue* clone_inc();
+	LSValue* move();
+	LSValue* move_inc();
 
 	virtual LSValue* getClass() const = 0;
 
@@ -235,9 +271,75 @@ public:
 	virtual RawType getRawType() const = 0;
 
 	static LSValue* parse(JsonValue& json);
+
+	static void inc_refs(LSValue* value);
+	static void dec_refs(LSValue* value);
+	static void delete_ref(LSValue* value);
+	static void delete_temporary(LSValue* value);
 };
 
 inline LSValue::~LSValue() { }
 
+/*
+ * Copy of the value, owned by the caller
+ */
+inline LSValue* LSValue::clone_inc() {
+	LSValue* copy = clone();
+	if (!copy->native) copy->refs++;
+	return copy;
+}
+
+/*
+ * The value itself if it's a temporary, a copy otherwise
+ */
+inline LSValue* LSValue::move() {
+	if (native or refs > 0) {
+		return clone();
+	}
+	return this;
+}
+
+/*
+ * Same as move(), the result being owned by the caller
+ */
+inline LSValue* LSValue::move_inc() {
+	if (native or refs > 0) {
+		return clone_inc();
+	}
+	refs++;
+	return this;
+}
+
+inline void LSValue::inc_refs(LSValue* value) {
+	if (!value->native) value->refs++;
+}
+
+/*
+ * Drop a reference without deleting the value : it becomes a temporary
+ * again if nobody else holds it
+ */
+inline void LSValue::dec_refs(LSValue* value) {
+	if (!value->native) value->refs--;
+}
+
+inline void LSValue::delete_ref(LSValue* value) {
+	if (value == nullptr or value->native) return;
+	if (--value->refs <= 0) {
+		delete value;
+	}
+}
+
+inline void LSValue::delete_temporary(LSValue* value) {
+	if (value != nullptr and value->refs == 0 and !value->native) {
+		delete value;
+	}
+}
+
+template <class T>
+inline T* make_native(T* value) {
+	value->native = true;
+	return value;
+}
+
 #endif
 
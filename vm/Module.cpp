@@ -9,13 +9,13 @@ Module::~Module() {}
 
 void Module::include(SemanticAnalyser* analyser, Program* program) {
 
-	LSClass* clazz = new LSClass(name);
+	LSClass* clazz = make_native(new LSClass(name));
 	program->system_vars.insert(pair<string, LSValue*>(name, clazz));
 	SemanticVar* var = analyser->add_var(new Token(name), Type::CLASS, nullptr);
 
 	for (auto m : methods) {
 		var->attr_types.insert(pair<string, Type>(m.name, m.type));
-		clazz->addStaticField(m.name, new LSFunction(m.addr));
+		clazz->addStaticField(m.name, make_native(new LSFunction(m.addr)));
 	}
 }
 
@@ -0,0 +1,193 @@
+#include "Server.hpp"
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+const string Server::TOO_LONG = "{\"success\":false,\"errors\":[{\"message\":\"Job too long\"}]}";
+
+Server::Server(VM& vm) : vm(vm) {}
+
+Server::~Server() {
+	unique_lock<mutex> lock(connections_lock);
+	connection_ended.wait(lock, [this]() { return connections == 0; });
+}
+
+string Server::answer(VM& vm, const string& line) {
+	Job job;
+	if (!Job::parse(line, job)) {
+		return "{\"success\":false,\"errors\":[{\"message\":\"Invalid job\"}]}";
+	}
+	return vm.execute_job(job);
+}
+
+/*
+ * Answers the jobs of the stream until its end
+ */
+void Server::serve(istream& in, ostream& out) {
+	string line;
+	bool rejected = false;
+	int c;
+	while ((c = in.get()) != EOF) {
+		if (c != '\n') {
+			if (!too_long(line.size() + 1)) {
+				line.push_back(c);
+			} else {
+				rejected = true;
+			}
+			continue;
+		}
+		if (rejected) {
+			out << TOO_LONG << endl;
+		} else if (!line.empty()) {
+			out << answer(vm, line) << endl;
+		}
+		line.clear();
+		rejected = false;
+	}
+	if (rejected) {
+		out << TOO_LONG << endl;
+	} else if (!line.empty()) {
+		out << answer(vm, line) << endl;
+	}
+}
+
+bool Server::too_long(size_t size) const {
+	return max_line != 0 and size > max_line;
+}
+
+unique_ptr<VM> Server::take_vm() {
+	unique_ptr<VM> taken;
+	{
+		lock_guard<mutex> guard(idle_lock);
+		if (!idle_vms.empty()) {
+			taken = move(idle_vms.back());
+			idle_vms.pop_back();
+		}
+	}
+	if (!taken) {
+		taken.reset(new VM());
+	}
+	taken->heap_cap = vm.heap_cap;
+	taken->operations_limit = vm.operations_limit;
+	return taken;
+}
+
+void Server::give_back_vm(unique_ptr<VM> given) {
+	lock_guard<mutex> guard(idle_lock);
+	idle_vms.push_back(move(given));
+}
+
+static bool send_all(int connection, const string& data) {
+	size_t sent = 0;
+	while (sent < data.size()) {
+		ssize_t n = send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (n < 0 and errno == EINTR) continue;
+		if (n <= 0) return false;
+		sent += n;
+	}
+	return true;
+}
+
+/*
+ * A connection gets a VM for each of its jobs : the VMs of the idle
+ * connections serve the others
+ */
+void Server::serve_connection(int connection) {
+
+	string buffer;
+	// The rest of a line too long is dropped until its end
+	bool skipping = false;
+	char data[4096];
+	bool open = true;
+	while (open) {
+		ssize_t n = recv(connection, data, sizeof(data), 0);
+		if (n < 0 and errno == EINTR) continue;
+		if (n <= 0) break;
+		buffer.append(data, n);
+
+		size_t end;
+		while (open and (end = buffer.find('\n')) != string::npos) {
+			string line = buffer.substr(0, end);
+			buffer.erase(0, end + 1);
+			if (skipping) {
+				skipping = false;
+				continue;
+			}
+			if (line.empty()) continue;
+
+			string result;
+			if (too_long(line.size())) {
+				result = TOO_LONG;
+			} else {
+				unique_ptr<VM> connection_vm = take_vm();
+				result = answer(*connection_vm, line);
+				give_back_vm(move(connection_vm));
+			}
+			open = send_all(connection, result + "\n");
+		}
+		if (open and !skipping and too_long(buffer.size())) {
+			open = send_all(connection, TOO_LONG + "\n");
+			skipping = true;
+		}
+		if (skipping) {
+			buffer.clear();
+		}
+	}
+	close(connection);
+
+	lock_guard<mutex> guard(connections_lock);
+	connections--;
+	connection_ended.notify_all();
+}
+
+/*
+ * Serves the connections of a local socket, each one in its own thread,
+ * until the socket fails. Returns once the connections are all served.
+ */
+bool Server::listen(const string& socket_path) {
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		return false;
+	}
+	strcpy(address.sun_path, socket_path.c_str());
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0) {
+		return false;
+	}
+	unlink(socket_path.c_str());
+	if (bind(server, (sockaddr*) &address, sizeof(address)) < 0 or ::listen(server, SOMAXCONN) < 0) {
+		close(server);
+		return false;
+	}
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(connections_lock);
+			connection_ended.wait(lock, [this]() { return max_connections == 0 or connections < max_connections; });
+		}
+		int connection = accept(server, nullptr, nullptr);
+		if (connection < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		{
+			lock_guard<mutex> guard(connections_lock);
+			connections++;
+		}
+		thread(&Server::serve_connection, this, connection).detach();
+	}
+	close(server);
+
+	unique_lock<mutex> lock(connections_lock);
+	connection_ended.wait(lock, [this]() { return connections == 0; });
+	return true;
+}
@@ -0,0 +1,69 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include "VM.hpp"
+
+/*
+ * Long-lived process executing the jobs it receives (see Job::parse), one
+ * JSON object by line, and answering their results, one by line, in the
+ * same order. Its VMs are kept from a job to another : the JIT, the
+ * standard modules and the compiled programs stay ready.
+ */
+class Server {
+public:
+
+	/*
+	 * VM answering the jobs read from a stream, and giving its limits
+	 * to the VMs of the connections
+	 */
+	VM& vm;
+
+	static const size_t DEFAULT_MAX_LINE = 1024 * 1024;
+	static const unsigned DEFAULT_MAX_CONNECTIONS = 64;
+
+	/*
+	 * Maximum size of a job, in bytes (0 for no limit) : a longer line is
+	 * rejected without being kept, up to its end
+	 */
+	size_t max_line = DEFAULT_MAX_LINE;
+
+	/*
+	 * Maximum number of connections served at once (0 for no limit), each
+	 * one by a thread and a VM : the next ones wait to be accepted
+	 */
+	unsigned max_connections = DEFAULT_MAX_CONNECTIONS;
+
+	Server(VM& vm);
+	virtual ~Server();
+
+	void serve(std::istream& in, std::ostream& out);
+	bool listen(const std::string& socket_path);
+
+	static std::string answer(VM& vm, const std::string& line);
+	static const std::string TOO_LONG;
+
+private:
+
+	// VMs not used by a connection
+	std::mutex idle_lock;
+	std::vector<std::unique_ptr<VM>> idle_vms;
+
+	// Connections being served : the server is not destroyed before their end
+	std::mutex connections_lock;
+	std::condition_variable connection_ended;
+	unsigned connections = 0;
+
+	bool too_long(size_t size) const;
+
+	std::unique_ptr<VM> take_vm();
+	void give_back_vm(std::unique_ptr<VM>);
+	void serve_connection(int connection);
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <string>
+
+/*
+ * SHA-256 digest of some data, as 32 raw bytes : a key that can't be made
+ * to collide on purpose, even for the programs sent by the clients of a server
+ */
+std::string sha256(const std::string& data);
+
+#endif
@@ -1,108 +1,326 @@
 #include "VM.hpp"
 #include "Context.hpp"
+#include "Arena.hpp"
+#include "Sha256.hpp"
 #include "../parser/lexical/LexicalAnalyser.hpp"
+#include "../parser/lexical/TokenFile.hpp"
 #include "../parser/syntaxic/SyntaxicAnalyser.hpp"
 #include "../parser/semantic/SemanticAnalyser.hpp"
 #include "../parser/semantic/SemanticError.hpp"
 #include <sstream>
 #include <chrono>
+#include <climits>
+#include <algorithm>
+#include <mutex>
 
 using namespace std;
 
-VM::VM() {}
+/*
+ * Shared by all the VMs of the process : initialized once, by the first VM
+ * created, whatever its thread
+ */
+static once_flag process_init;
+
+thread_local VM* VM::running = nullptr;
+
+VM::VM() {
+	call_once(process_init, []() {
+		jit_init();
+		LSNumber::build_cache();
+	});
+}
 
-VM::~VM() {}
+VM::~VM() {
+	for (auto program : programs) {
+		jit_context_destroy(program.second.jit_context);
+	}
+}
 
-map<string, jit_value_t> internals;
-map<string, jit_value_t> globals;
-map<string, Type> globals_types;
-map<string, jit_value_t> locals;
+
+/*
+ * Makes the values of an execution live in an arena : its own one, dropped
+ * at once when the execution ends (its context is returned as JSON, so no
+ * value needs to survive it), or the one of its live context
+ */
+class ExecutionArena {
+public:
+	Arena* previous;
+	ExecutionArena(Arena* arena) : previous(LSValue::arena) {
+		LSValue::arena = arena;
+	}
+	~ExecutionArena() {
+		LSValue::arena = previous;
+	}
+};
+
+/*
+ * Makes the values created while compiling a program (constants of the
+ * code) live on the heap : the program outlives the execution arena
+ */
+class CompilationHeap {
+public:
+	Arena* previous;
+	CompilationHeap() : previous(LSValue::arena) {
+		LSValue::arena = nullptr;
+	}
+	~CompilationHeap() {
+		LSValue::arena = previous;
+	}
+};
+
+string VM::program_key(const string& code, const Context& context, bool toplevel) {
+	ostringstream key;
+	key << toplevel;
+	for (auto var : context.types()) {
+		key << var.first << ":" << (int) var.second << ",";
+	}
+	key << "|" << sha256(code);
+	return key.str();
+}
+
+/*
+ * Moves the program first in the order of use, and destroys the least recently
+ * used ones over the cap. A kept program leaves the order.
+ */
+void VM::use_program(CompiledProgram& program, bool keep) {
+	if (program.kept) {
+		return;
+	}
+	if (keep) {
+		programs_use.erase(program.use);
+		program.kept = true;
+		return;
+	}
+	programs_use.splice(programs_use.begin(), programs_use, program.use);
+	while (programs_cap != 0 && programs_use.size() > programs_cap) {
+		auto dropped = programs.find(programs_use.back());
+		jit_context_destroy(dropped->second.jit_context);
+		programs.erase(dropped);
+		programs_use.pop_back();
+	}
+}
 
 string VM::execute(const string code, string ctx, ExecMode mode) {
+	return execute_program(code, nullptr, ctx, mode);
+}
+
+/*
+ * Executes a script precompiled in a .lsc file (see TokenFile) : the source
+ * is known by the digest of the file, and its syntax tree is not built again
+ */
+string VM::execute_file(const string path, string ctx, ExecMode mode) {
+
+	vector<Token> tokens;
+	Program* program;
+	string digest;
+	if (!TokenFile::load(path, tokens, program, digest)) {
+		*output << "Can't load the precompiled file " << path << endl;
+		return ctx;
+	}
+	return execute_program("lsc:" + digest, program, ctx, mode);
+}
+
+/*
+ * Executes a code in a live context, kept from an execution to another
+ */
+string VM::execute(const string code, Context& context, ExecMode mode) {
+	if (context.arena == nullptr) {
+		context.arena.reset(new Arena());
+	}
+	string result;
+	{
+		ExecutionArena execution_arena(context.arena.get());
+		result = execute_context(code, nullptr, context, mode);
+	}
+	// The values of a stopped execution can't be trusted
+	if (last_error != ExecError::NONE) {
+		context.clear();
+	}
+	return result;
+}
+
+/*
+ * Executes a source code, or its program when it's already parsed (the source
+ * then only identifies it), in a context given as JSON
+ */
+string VM::execute_program(const string& source, Program* parsed, string ctx, ExecMode mode) {
+
+	Arena arena;
+	ExecutionArena execution_arena(&arena);
+	Context context { ctx };
+
+	string result = execute_context(source, parsed, context, mode);
+	// The context is returned unchanged when the execution fails
+	if (mode == ExecMode::TEST or !result.empty()) {
+		return result;
+	}
+	return ctx;
+}
+
+/*
+ * Runs a program in a context, in the arena of the running execution. Returns
+ * the result in the test mode, and the new context as JSON when the program
+ * ends in the top level mode with a context read from JSON (the command mode
+ * writes it in its output). A program already parsed is owned by the call.
+ */
+string VM::execute_context(const string& source, Program* parsed, Context& context, ExecMode mode) {
 
 	auto compile_start = chrono::high_resolution_clock::now();
+	last_error = ExecError::NONE;
+
+	Arena& arena = *LSValue::arena;
+	bool toplevel = mode != ExecMode::NORMAL && mode != ExecMode::TEST;
 
-	// Lexical analysis
-	LexicalAnalyser lex;
-	vector<Token> tokens = lex.analyse(code);
+	string cache_key = program_key(source, context, toplevel);
+	auto compiled = programs.find(cache_key);
 
-	// Syntaxical analysis
-	SyntaxicAnalyser syn;
-	Program* program = syn.analyse(tokens);
+	if (compiled != programs.end()) {
+		delete parsed;
 
-	if (syn.getErrors().size() > 0) {
-		if (mode == ExecMode::COMMAND_JSON) {
+	} else {
 
-			cout << "{\"success\":false,\"errors\":[";
-			for (auto error : syn.getErrors()) {
-				cout << "{\"line\":" << error->token->line << ",\"message\":\"" << error->message << "\"}";
+		CompilationHeap compilation_heap;
+
+		// Lexical and syntaxical analyses, unless the program is parsed
+		SyntaxicAnalyser syn;
+		Program* program = parsed;
+		if (program == nullptr) {
+			LexicalAnalyser lex;
+			vector<Token> tokens = lex.analyse(source);
+			program = syn.analyse(tokens);
+		}
+
+		if (syn.getErrors().size() > 0) {
+			if (mode == ExecMode::COMMAND_JSON) {
+
+				*output << "{\"success\":false,\"errors\":[";
+				vector<SyntaxicalError*> errors = syn.getErrors();
+				for (size_t i = 0; i < errors.size(); ++i) {
+					SyntaxicalError* error = errors[i];
+					if (i > 0) *output << ",";
+					*output << "{\"line\":" << error->token->line << ",\"message\":";
+					LSValue::json_string(*output, error->message) << "}";
+				}
+				*output << "]}" << endl;
+
+			} else {
+				for (auto error : syn.getErrors()) {
+					*output << "Line " << error->token->line << " : " <<  error->message << endl;
+				}
 			}
-			cout << "]}" << endl;
-			return ctx;
+			return mode == ExecMode::TEST ? "<error>" : "";
+		}
 
-		} else {
-			for (auto error : syn.getErrors()) {
-				cout << "Line " << error->token->line << " : " <<  error->message << endl;
+		// Semantic analysis
+		try {
+			SemanticAnalyser sem;
+			sem.analyse(program, &context);
+		} catch (SemanticError& e) {
+
+			if (mode == ExecMode::COMMAND_JSON) {
+				*output << "{\"success\":false,\"errors\":[{\"line\":" << e.token->line << ",\"message\":";
+				LSValue::json_string(*output, e.message) << "}]}" << endl;
+			} else {
+				*output << "Line " << e.token->line << " : " << e.message << endl;
 			}
-			return ctx;
+			return mode == ExecMode::TEST ? "<error>" : "";
 		}
-	}
 
-	// Semantic analysis
-	Compiler c;
-	Context context { ctx };
+		// Constant folding
+		program->fold();
 
-	try {
-		SemanticAnalyser sem;
-		sem.analyse(program, &context);
-	} catch (SemanticError& e) {
+		// Compilation
+		Compiler c(this);
 
-		if (mode == ExecMode::COMMAND_JSON) {
-			cout << "{\"success\":false,\"errors\":[{\"line\":" << e.token->line << ",\"message\":\"" << e.message << "\"}]}" << endl;
-		} else {
-			cout << "Line " << e.token->line << " : " << e.message << endl;
-		}
-		if (mode == ExecMode::TEST) {
-			return "<error>";
-		}
-		return ctx;
-	}
+		jit_context_t jit_context = jit_context_create();
+		jit_context_build_start(jit_context);
 
-	// Compilation
-	internals.clear();
-	globals.clear();
-	globals_types.clear();
-	locals.clear();
+		// The only parameter is the array of the context variables values
+		jit_type_t params[1] = {JIT_POINTER};
+		jit_type_t signature = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER_LONG, params, 1, 1);
+		jit_function_t F = jit_function_create(jit_context, signature);
 
-	jit_init();
-	jit_context_t jit_context = jit_context_create();
-	jit_context_build_start(jit_context);
+		program->compile_jit(c, F, context, toplevel);
 
-	jit_type_t params[0] = {};
-	jit_type_t signature = jit_type_create_signature(jit_abi_cdecl, JIT_INTEGER_LONG, params, 0, 1);
-	jit_function_t F = jit_function_create(jit_context, signature);
+		jit_function_compile(F);
+		jit_context_build_end(jit_context);
 
-	bool toplevel = mode != ExecMode::NORMAL && mode != ExecMode::TEST;
-	program->compile_jit(c, F, context, toplevel);
+		CompiledProgram program_compiled;
+		program_compiled.context_vars = program->context_vars;
+		delete program;
+		program_compiled.jit_context = jit_context;
+		program_compiled.function = F;
+		program_compiled.closure = jit_function_to_closure(F);
+		for (auto g : c.globals) {
+			program_compiled.globals.push_back(g.first);
+		}
+		compiled = programs.insert({cache_key, program_compiled}).first;
+		compiled->second.use = programs_use.insert(programs_use.begin(), cache_key);
+	}
+	use_program(compiled->second, context.arena != nullptr);
 
-	jit_function_compile(F);
-	jit_context_build_end(jit_context);
+	const vector<string>& program_globals = compiled->second.globals;
 
-	typedef LSValue* (*FF)();
-	FF fun = (FF) jit_function_to_closure(F);
+	// The context variables used by the program are materialized
+	vector<LSValue*> context_values;
+	for (const string& name : compiled->second.context_vars) {
+		context_values.push_back(context.get(name));
+	}
 
 	auto compile_end = chrono::high_resolution_clock::now();
 
 	/*
-	 * Execute
+	 * Execute : run by jit_function_apply, which catches the errors
+	 * stopping the program. The heap cap only applies while it's running.
 	 */
 	auto exe_start = chrono::high_resolution_clock::now();
-	LSValue* res = fun();
+	LSValue** context_data = context_values.data();
+	void* args[1] = {&context_data};
+	jit_long result = 0;
+	long operations_budget = operations_limit != 0 ? min(operations_limit, OPERATIONS_STOP - 1) : OPERATIONS_STOP - 1;
+	operations_left = operations_budget;
+	pending_error = ExecError::NONE;
+	VM* previous_running = running;
+	running = this;
+	arena.set_cap(heap_cap);
+	bool finished = jit_function_apply(compiled->second.function, args, &result);
+	arena.set_cap(0);
+	running = previous_running;
+	LSValue* res = (LSValue*) result;
 	auto exe_end = chrono::high_resolution_clock::now();
+	size_t memory_peak = arena.peak();
+	if (pending_error != ExecError::NONE) {
+		operations_left += OPERATIONS_STOP;
+	}
+	// The operations of the loop body stopped are counted before the check
+	long operations = min(operations_budget - operations_left, operations_budget);
 
 	long exe_time_ns = chrono::duration_cast<chrono::nanoseconds>(exe_end - exe_start).count();
 	long compile_time_ns = chrono::duration_cast<chrono::nanoseconds>(compile_end - compile_start).count();
 
+	// A stop requested after the last check stops the program at its end
+	last_error = pending_error;
+	if (!finished) {
+		last_error = (ExecError) (intptr_t) jit_exception_get_last();
+		jit_exception_clear_last();
+	} else if (last_error != ExecError::NONE) {
+		LSValue::delete_temporary(res);
+	}
+
+	if (last_error != ExecError::NONE) {
+
+		string message = error_message(last_error);
+
+		if (mode == ExecMode::COMMAND_JSON) {
+			*output << "{\"success\":false,\"time\":" << exe_time_ns << ",\"memory\":" << memory_peak << ",\"operations\":" << operations << ",\"errors\":[{\"message\":\"" << message << "\"}]}" << endl;
+		} else if (mode == ExecMode::TEST) {
+			return "<error>";
+		} else {
+			*output << "Execution stopped : " << message << endl;
+		}
+		return "";
+	}
+
 	double exe_time_ms = (((double) exe_time_ns / 1000) / 1000);
 	double compile_time_ms = (((double) compile_time_ns / 1000) / 1000);
 
@@ -116,53 +334,93 @@ string VM::execute(const string code, string ctx, ExecMode mode) {
 		LSArray* res_array = (LSArray*) res;
 
 		ostringstream oss;
-		res_array->at(LSNumber::get(0))->print(oss);
+		LSNumber key(0);
+		res_array->at(&key)->print(oss);
 		res_string = oss.str();
 
-		string ctx = "{";
-
-		unsigned i = 0;
-		for (auto g : globals) {
-
-			LSValue* v = res_array->at(LSNumber::get(i + 1));
-			ctx += "\"" + g.first + "\":" + v->to_json();
-			if (i < globals.size() - 1) ctx += ",";
-			i++;
+		// The values of the globals are adopted by the context
+		map<string, LSValue*> globals;
+		for (size_t i = 0; i < program_globals.size(); ++i) {
+			globals[program_globals[i]] = res_array->list[i + 1];
 		}
-
-		ctx += "}";
+		context.update(globals);
+		delete res_array;
 
 		if (mode == ExecMode::TOP_LEVEL) {
-			cout << res_string << endl;
-			// cout << "ctx: " << ctx << endl;
-			cout << "(" << compile_time_ms << " ms + " << exe_time_ms << " ms)" << endl;
-			return ctx;
-		} else {
-			cout << "{\"success\":true,\"time\":" << exe_time_ns << ",\"ctx\":" << ctx << ",\"res\":\""
-					<< res_string << "\"}" << endl;
-			return ctx;
+			*output << res_string << endl;
+			*output << "(" << compile_time_ms << " ms + " << exe_time_ms << " ms)" << endl;
+			return context.arena == nullptr ? context.json() : "";
 		}
+		// The context is written in the output as it's serialized
+		*output << "{\"success\":true,\"time\":" << exe_time_ns << ",\"memory\":" << memory_peak << ",\"operations\":" << operations << ",\"ctx\":";
+		context.json(*output) << ",\"res\":";
+		LSValue::json_string(*output, res_string) << "}" << endl;
+		return "";
 
 	} else if (mode == ExecMode::NORMAL) {
 
 		ostringstream oss;
 		res->print(oss);
 		res_string = oss.str();
+		LSValue::delete_temporary(res);
 
-		cout << res_string << endl;
-		cout << "(" << compile_time_ms << "ms + " << exe_time_ms << " ms)" << endl;
-
-		return ctx;
+		*output << res_string << endl;
+		*output << "(" << compile_time_ms << "ms + " << exe_time_ms << " ms)" << endl;
 
 	} else if (mode == ExecMode::TEST) {
 
 		ostringstream oss;
 		res->print(oss);
 		res_string = oss.str();
-		return oss.str();
+		LSValue::delete_temporary(res);
+		return res_string;
 	}
 
-	return ctx;
+	return "";
+}
+
+void VM::throw_error(ExecError error) {
+	jit_exception_throw((void*) (intptr_t) error);
+}
+
+void VM::stop(ExecError error) {
+	if (pending_error == ExecError::NONE) {
+		pending_error = error;
+		operations_left -= OPERATIONS_STOP;
+	}
+}
+
+string VM::error_message(ExecError error) {
+	switch (error) {
+		case ExecError::HEAP_CAP: return "Memory limit exceeded";
+		case ExecError::OPERATIONS_LIMIT: return "Too many operations";
+		default: return "Execution error";
+	}
+}
+
+void operations_exceeded(VM* vm) {
+	VM::throw_error(vm->pending_error != ExecError::NONE ? vm->pending_error : ExecError::OPERATIONS_LIMIT);
+}
+
+/*
+ * Counts the operations once for the whole body of a loop or a function :
+ * a decrement of the operations left, the execution being stopped when
+ * there's none left
+ */
+void VM::inc_ops(jit_function_t& F, int amount) const {
+
+	jit_value_t left_address = JIT_CREATE_CONST_POINTER(F, (void*) &operations_left);
+	jit_value_t left = jit_insn_load_relative(F, left_address, 0, JIT_INTEGER_LONG);
+	left = jit_insn_sub(F, left, JIT_CREATE_CONST_LONG(F, JIT_INTEGER_LONG, amount));
+	jit_insn_store_relative(F, left_address, 0, left);
+
+	jit_label_t label_ok = jit_label_undefined;
+	jit_insn_branch_if_not(F, jit_insn_lt(F, left, JIT_CREATE_CONST_LONG(F, JIT_INTEGER_LONG, 0)), &label_ok);
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
+	jit_value_t vm = JIT_CREATE_CONST_POINTER(F, (void*) this);
+	jit_insn_call_native(F, "operations_exceeded", (void*) operations_exceeded, sig, &vm, 1, 0);
+	jit_insn_label(F, &label_ok);
 }
 
 LSValue* create_null_object(int) {
@@ -172,7 +430,7 @@ LSValue* create_number_object(int n) {
 	return LSNumber::get(n);
 }
 LSValue* create_bool_object(bool n) {
-	return new LSBoolean(n);
+	return LSBoolean::get(n);
 }
 LSValue* create_func_object(void* f) {
 	return new LSFunction(f);
@@ -206,7 +464,7 @@ jit_value_t VM::value_to_pointer(jit_function_t& F, jit_value_t& v, Type type) {
 	jit_type_t args_types[1] = {
 		(type.raw_type == RawType::FUNCTION) ? JIT_POINTER :
 		(type.raw_type == RawType::LONG) ? JIT_INTEGER_LONG :
-		(type.raw_type == RawType::FLOAT) ?	JIT_FLOAT :
+		(type.raw_type == RawType::FLOAT or floatt) ? JIT_FLOAT :
 			JIT_INTEGER
 	};
 	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args_types, 1, 0);
@@ -230,7 +488,6 @@ bool VM::get_number(jit_function_t& F, jit_value_t& val) {
 	return false;
 }*/
 
-map<int, void*> VM::globals_vars;
 
 void VM::add_global_var(int index, void* value) {
 	cout << "add_global_var " << index << " : " << value << endl;
@@ -270,3 +527,104 @@ void VM::push_array_pointer(jit_function_t& F, jit_value_t& array, jit_value_t&
 	jit_value_t args_v[] = {array, value};
 	jit_insn_call_native(F, "push", (void*) push_array_pointer, sig, args_v, 2, JIT_CALL_NOTHROW);
 }
+
+void VM_inc_refs(LSValue* value) {
+	LSValue::inc_refs(value);
+}
+
+void VM_dec_refs(LSValue* value) {
+	LSValue::dec_refs(value);
+}
+
+void VM_delete_ref(LSValue* value) {
+	LSValue::delete_ref(value);
+}
+
+void VM_delete_temporary(LSValue* value) {
+	LSValue::delete_temporary(value);
+}
+
+/*
+ * Release an argument after a call, keeping the result alive even if
+ * it belongs to the argument
+ */
+void VM_delete_arg(LSValue* arg, LSValue* res) {
+	if (res == nullptr) {
+		LSValue::delete_ref(arg);
+		return;
+	}
+	LSValue::inc_refs(res);
+	LSValue::delete_ref(arg);
+	LSValue::dec_refs(res);
+}
+
+LSValue* VM_move_inc(LSValue* value) {
+	return value->move_inc();
+}
+
+/*
+ * Reference taken by a function on an argument. The native values are shared
+ * by the whole VM, so the function gets its own copy to be able to modify it.
+ */
+LSValue* VM_take_arg(LSValue* value) {
+	if (value->native) {
+		return value->clone_inc();
+	}
+	value->refs++;
+	return value;
+}
+
+void VM::inc_refs(jit_function_t& F, jit_value_t& value) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
+	jit_insn_call_native(F, "inc_refs", (void*) VM_inc_refs, sig, &value, 1, JIT_CALL_NOTHROW);
+}
+
+void VM::dec_refs(jit_function_t& F, jit_value_t& value) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
+	jit_insn_call_native(F, "dec_refs", (void*) VM_dec_refs, sig, &value, 1, JIT_CALL_NOTHROW);
+}
+
+void VM::delete_ref(jit_function_t& F, jit_value_t& value) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
+	jit_insn_call_native(F, "delete_ref", (void*) VM_delete_ref, sig, &value, 1, JIT_CALL_NOTHROW);
+}
+
+void VM::delete_temporary(jit_function_t& F, jit_value_t& value) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 1, 0);
+	jit_insn_call_native(F, "delete_temporary", (void*) VM_delete_temporary, sig, &value, 1, JIT_CALL_NOTHROW);
+}
+
+void VM::delete_arg(jit_function_t& F, jit_value_t& arg, jit_value_t& res) {
+	jit_type_t args[2] = {JIT_POINTER, JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, jit_type_void, args, 2, 0);
+	jit_value_t args_v[] = {arg, res};
+	jit_insn_call_native(F, "delete_arg", (void*) VM_delete_arg, sig, args_v, 2, JIT_CALL_NOTHROW);
+}
+
+jit_value_t VM::move_inc(jit_function_t& F, jit_value_t& value) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args, 1, 0);
+	return jit_insn_call_native(F, "move_inc", (void*) VM_move_inc, sig, &value, 1, JIT_CALL_NOTHROW);
+}
+
+void VM::take_arg(jit_function_t& F, jit_value_t& arg) {
+	jit_type_t args[1] = {JIT_POINTER};
+	jit_type_t sig = jit_type_create_signature(jit_abi_cdecl, JIT_POINTER, args, 1, 0);
+	jit_insn_store(F, arg, jit_insn_call_native(F, "take_arg", (void*) VM_take_arg, sig, &arg, 1, JIT_CALL_NOTHROW));
+}
+
+/*
+ * Store a value in a variable owning its value : the new value is adopted
+ * (or copied) and the previous one is released
+ */
+jit_value_t VM::store_value(jit_function_t& F, jit_value_t& var, jit_value_t& value) {
+	jit_value_t old = jit_insn_load(F, var);
+	jit_value_t val = move_inc(F, value);
+	jit_insn_store(F, var, val);
+	delete_ref(F, old);
+	return val;
+}
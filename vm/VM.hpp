@@ -2,6 +2,12 @@
 #define VM_HPP
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <unordered_map>
+#include <list>
+#include <climits>
 #include <jit/jit.h>
 
 #include "value/LSNull.hpp"
@@ -30,22 +36,156 @@ enum class ExecMode {
 	NORMAL, TOP_LEVEL, COMMAND_JSON, TEST
 };
 
+/*
+ * Errors stopping a running program : thrown from its operations checks
+ * with jit_exception_throw, up to the jit_function_apply of the VM. The
+ * natives never throw them : they only make the next check fail.
+ */
+enum class ExecError {
+	NONE, HEAP_CAP, OPERATIONS_LIMIT
+};
+
+class Context;
+class Token;
+class Program;
+
+/*
+ * A program compiled once and executed again without being analysed nor
+ * compiled : its context variables are passed as the function argument
+ */
+class CompiledProgram {
+public:
+	jit_context_t jit_context;
+	jit_function_t function;
+	void* closure;
+	std::vector<std::string> context_vars;
+	std::vector<std::string> globals;
+	// Kept whatever the cap of the programs, or its place in their order of use
+	bool kept = false;
+	std::list<std::string>::iterator use;
+};
+
+/*
+ * Program to execute in a context, sent to a batch or a server. Its limits
+ * can only lower the ones of the VM (0 for the limits of the VM).
+ */
+class Job {
+public:
+	std::string code;
+	std::string context = "{}";
+	// Identifier of the job, as JSON, repeated in its result
+	std::string id;
+	long heap_cap = 0;
+	long operations_limit = 0;
+	bool valid_context = true;
+
+	static bool parse(std::string line, Job& job);
+};
+
+/*
+ * A VM runs one execution at a time, and owns its compiled programs :
+ * several VMs can run executions at once, one per thread
+ */
 class VM {
 public:
 
-	static std::map<int, void*> globals_vars;
-	static void add_global_var(int, void*);
+	std::map<int, void*> globals_vars;
+	void add_global_var(int, void*);
+
+	static const size_t DEFAULT_HEAP_CAP = 1024 * 1024 * 1024;
+
+	/*
+	 * Maximum memory of the values of an execution, in bytes (0 for no limit) :
+	 * the execution is stopped when it's reached
+	 */
+	size_t heap_cap = DEFAULT_HEAP_CAP;
+
+	/*
+	 * Maximum number of operations of an execution (0 for no limit). The
+	 * operations are counted by the compiled code : each iteration of a loop
+	 * and each call of a function costs the number of instructions of its body.
+	 */
+	long operations_limit = 0;
+
+	// Operations left to the running execution
+	long operations_left = 0;
+
+	/*
+	 * Error to stop the running execution with at its next operations check :
+	 * the natives can't stop it themselves, their C++ frames can't be unwound
+	 * by the JIT exceptions. The operations left are lowered by OPERATIONS_STOP
+	 * to make the check fail.
+	 */
+	static const long OPERATIONS_STOP = LONG_MAX / 2;
+	ExecError pending_error = ExecError::NONE;
+	void stop(ExecError);
+
+	// VM running an execution in the current thread
+	static thread_local VM* running;
+
+	// Error which stopped the last execution
+	ExecError last_error = ExecError::NONE;
+
+	// Stream where the executions print their results
+	std::ostream* output = &std::cout;
 
 	VM();
 	virtual ~VM();
 
+	static const size_t DEFAULT_PROGRAMS_CAP = 512;
+
+	/*
+	 * Maximum number of compiled programs kept (0 for no limit) : the least
+	 * recently used one is destroyed to make room. The programs executed in a
+	 * live context are kept, its values can hold their functions.
+	 */
+	size_t programs_cap = DEFAULT_PROGRAMS_CAP;
+
+	/*
+	 * Compiled programs, by digest of the source code, context variables types
+	 * and mode. Their keys are in the order of use, the last used first.
+	 */
+	std::unordered_map<std::string, CompiledProgram> programs;
+	std::list<std::string> programs_use;
+	void use_program(CompiledProgram& program, bool keep);
+
 	std::string execute(const std::string code, std::string ctx, ExecMode mode);
+	std::string execute(const std::string code, Context& context, ExecMode mode);
+	std::string execute_file(const std::string path, std::string ctx, ExecMode mode);
+	std::string execute_program(const std::string& source, Program* parsed, std::string ctx, ExecMode mode);
+	std::string execute_context(const std::string& source, Program* parsed, Context& context, ExecMode mode);
+	static std::string program_key(const std::string& code, const Context&, bool toplevel);
+
+	/*
+	 * Executes the jobs in a pool of threads, each one with its own VM kept
+	 * from a batch to another (with its compiled programs). Returns the JSON
+	 * results of the jobs (see ExecMode::COMMAND_JSON), in their order.
+	 */
+	std::vector<std::string> execute_batch(const std::vector<Job>& jobs, unsigned threads = 0);
+	std::string execute_job(const Job& job);
+	std::vector<std::unique_ptr<VM>> workers;
+
+	static void throw_error(ExecError);
+	static std::string error_message(ExecError);
+	void inc_ops(jit_function_t&, int amount) const;
 
 	static jit_value_t value_to_pointer(jit_function_t&, jit_value_t&, Type);
 	static jit_value_t new_array(jit_function_t&);
 	// static bool is_number(void* v);
 	static void push_array_value(jit_function_t&, jit_value_t&, jit_value_t&);
 	static void push_array_pointer(jit_function_t&, jit_value_t&, jit_value_t&);
+
+	/*
+	 * Reference counting of the values
+	 */
+	static void inc_refs(jit_function_t&, jit_value_t&);
+	static void dec_refs(jit_function_t&, jit_value_t&);
+	static void delete_ref(jit_function_t&, jit_value_t&);
+	static void delete_temporary(jit_function_t&, jit_value_t&);
+	static void delete_arg(jit_function_t&, jit_value_t&, jit_value_t&);
+	static jit_value_t move_inc(jit_function_t&, jit_value_t&);
+	static void take_arg(jit_function_t&, jit_value_t&);
+	static jit_value_t store_value(jit_function_t&, jit_value_t&, jit_value_t&);
 };
 
 #endif
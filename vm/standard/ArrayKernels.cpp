@@ -0,0 +1,451 @@
+#include "ArrayKernels.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ARRAY_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/*
+ * Scalar versions, also used for the ends of the arrays by the others
+ */
+static double scalar_sum_ints(const int* values, size_t size) {
+	int64_t sum = 0;
+	for (size_t i = 0; i < size; ++i) {
+		sum += values[i];
+	}
+	return sum;
+}
+
+static double scalar_sum_reals(const double* values, size_t size) {
+	double sum = 0;
+	for (size_t i = 0; i < size; ++i) {
+		sum += values[i];
+	}
+	return sum;
+}
+
+template <class T>
+static T scalar_max(const T* values, size_t size) {
+	T best = values[0];
+	for (size_t i = 1; i < size; ++i) {
+		if (values[i] > best) best = values[i];
+	}
+	return best;
+}
+
+template <class T>
+static T scalar_min(const T* values, size_t size) {
+	T best = values[0];
+	for (size_t i = 1; i < size; ++i) {
+		if (values[i] < best) best = values[i];
+	}
+	return best;
+}
+
+template <class T>
+static long scalar_find(const T* values, size_t size, T value) {
+	for (size_t i = 0; i < size; ++i) {
+		if (values[i] == value) return i;
+	}
+	return -1;
+}
+
+template <class T>
+static void scalar_fill(T* values, size_t size, T value) {
+	fill(values, values + size, value);
+}
+
+/*
+ * Element-wise operations : their loops are vectorized by the compiler, for
+ * the target of the function in which they are inlined. The operand equal to
+ * the result is read through it, the compiler proving then that the values
+ * don't overlap.
+ */
+#define ELEMENT_WISE inline __attribute__((always_inline)) static
+
+struct Add {
+	int operator () (int a, int b) const { return (unsigned) a + (unsigned) b; }
+	double operator () (double a, double b) const { return a + b; }
+};
+struct Sub {
+	int operator () (int a, int b) const { return (unsigned) a - (unsigned) b; }
+	double operator () (double a, double b) const { return a - b; }
+};
+struct Mul {
+	int operator () (int a, int b) const { return (unsigned) a * (unsigned) b; }
+	double operator () (double a, double b) const { return a * b; }
+};
+struct Div {
+	double operator () (double a, double b) const { return a / b; }
+};
+
+template <class Op, class T>
+ELEMENT_WISE void map_values(T* result, const T* a, T b, size_t size) {
+	Op op;
+	if (result == a) {
+		for (size_t i = 0; i < size; ++i) result[i] = op(result[i], b);
+	} else {
+		for (size_t i = 0; i < size; ++i) result[i] = op(a[i], b);
+	}
+}
+
+template <class Op, class T>
+ELEMENT_WISE void zip_values(T* result, const T* a, const T* b, size_t size) {
+	Op op;
+	if (result == a) {
+		for (size_t i = 0; i < size; ++i) result[i] = op(result[i], b[i]);
+	} else if (result == b) {
+		for (size_t i = 0; i < size; ++i) result[i] = op(a[i], result[i]);
+	} else {
+		for (size_t i = 0; i < size; ++i) result[i] = op(a[i], b[i]);
+	}
+}
+
+ELEMENT_WISE void map_ints(ArrayKernels::Operation op, int* result, const int* a, int b, size_t size) {
+	switch (op) {
+		case ArrayKernels::ADD: map_values<Add>(result, a, b, size); break;
+		case ArrayKernels::SUB: map_values<Sub>(result, a, b, size); break;
+		default: map_values<Mul>(result, a, b, size); break;
+	}
+}
+
+ELEMENT_WISE void map_reals(ArrayKernels::Operation op, double* result, const double* a, double b, size_t size) {
+	switch (op) {
+		case ArrayKernels::ADD: map_values<Add>(result, a, b, size); break;
+		case ArrayKernels::SUB: map_values<Sub>(result, a, b, size); break;
+		case ArrayKernels::MUL: map_values<Mul>(result, a, b, size); break;
+		default: map_values<Div>(result, a, b, size); break;
+	}
+}
+
+ELEMENT_WISE void zip_ints(ArrayKernels::Operation op, int* result, const int* a, const int* b, size_t size) {
+	switch (op) {
+		case ArrayKernels::ADD: zip_values<Add>(result, a, b, size); break;
+		case ArrayKernels::SUB: zip_values<Sub>(result, a, b, size); break;
+		default: zip_values<Mul>(result, a, b, size); break;
+	}
+}
+
+ELEMENT_WISE void zip_reals(ArrayKernels::Operation op, double* result, const double* a, const double* b, size_t size) {
+	switch (op) {
+		case ArrayKernels::ADD: zip_values<Add>(result, a, b, size); break;
+		case ArrayKernels::SUB: zip_values<Sub>(result, a, b, size); break;
+		case ArrayKernels::MUL: zip_values<Mul>(result, a, b, size); break;
+		default: zip_values<Div>(result, a, b, size); break;
+	}
+}
+
+ELEMENT_WISE void to_reals(double* result, const int* values, size_t size) {
+	for (size_t i = 0; i < size; ++i) result[i] = values[i];
+}
+
+static void scalar_map_ints(ArrayKernels::Operation op, int* result, const int* a, int b, size_t size) {
+	map_ints(op, result, a, b, size);
+}
+static void scalar_map_reals(ArrayKernels::Operation op, double* result, const double* a, double b, size_t size) {
+	map_reals(op, result, a, b, size);
+}
+static void scalar_zip_ints(ArrayKernels::Operation op, int* result, const int* a, const int* b, size_t size) {
+	zip_ints(op, result, a, b, size);
+}
+static void scalar_zip_reals(ArrayKernels::Operation op, double* result, const double* a, const double* b, size_t size) {
+	zip_reals(op, result, a, b, size);
+}
+static void scalar_to_reals(double* result, const int* values, size_t size) {
+	to_reals(result, values, size);
+}
+
+static const ArrayKernels scalar_kernels = {
+	"scalar",
+	scalar_sum_ints, scalar_sum_reals,
+	scalar_max<int>, scalar_min<int>, scalar_max<double>, scalar_min<double>,
+	scalar_find<int>, scalar_find<double>,
+	scalar_fill<int>, scalar_fill<double>,
+	scalar_map_ints, scalar_map_reals, scalar_zip_ints, scalar_zip_reals, scalar_to_reals
+};
+
+#if ARRAY_KERNELS_X86
+
+/*
+ * The lanes of the vectors are reduced with the scalar versions : the order of
+ * the comparisons stays the one of the scalar loops (a NaN real is never
+ * taken as the maximum or the minimum, unless it's the first value)
+ */
+template <bool max, class T>
+static T best_of(const T* lanes, size_t count, const T* values, size_t i, size_t size) {
+	T result = max ? scalar_max(lanes, count) : scalar_min(lanes, count);
+	for (; i < size; ++i) {
+		if (max ? values[i] > result : values[i] < result) result = values[i];
+	}
+	return result;
+}
+
+/*
+ * SSE2
+ */
+static double sse2_sum_ints(const int* values, size_t size) {
+	__m128i sum = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+		// Sign extended to 64 bits : the sum can't overflow
+		__m128i sign = _mm_srai_epi32(v, 31);
+		sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+	}
+	int64_t lanes[2];
+	_mm_storeu_si128((__m128i*) lanes, sum);
+	return lanes[0] + lanes[1] + (int64_t) scalar_sum_ints(values + i, size - i);
+}
+
+static double sse2_sum_reals(const double* values, size_t size) {
+	__m128d sum0 = _mm_setzero_pd();
+	__m128d sum1 = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		sum0 = _mm_add_pd(sum0, _mm_loadu_pd(values + i));
+		sum1 = _mm_add_pd(sum1, _mm_loadu_pd(values + i + 2));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+	return lanes[0] + lanes[1] + scalar_sum_reals(values + i, size - i);
+}
+
+// No comparison of 32 bits integers in SSE2 : a mask selects the values
+template <bool max>
+static int sse2_best_int(const int* values, size_t size) {
+	if (size < 4) {
+		return max ? scalar_max(values, size) : scalar_min(values, size);
+	}
+	__m128i best = _mm_loadu_si128((const __m128i*) values);
+	size_t i = 4;
+	for (; i + 4 <= size; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+		__m128i better = max ? _mm_cmpgt_epi32(v, best) : _mm_cmplt_epi32(v, best);
+		best = _mm_or_si128(_mm_and_si128(better, v), _mm_andnot_si128(better, best));
+	}
+	int lanes[4];
+	_mm_storeu_si128((__m128i*) lanes, best);
+	return best_of<max>(lanes, 4, values, i, size);
+}
+
+template <bool max>
+static double sse2_best_real(const double* values, size_t size) {
+	if (size < 2) {
+		return values[0];
+	}
+	__m128d best = _mm_set1_pd(values[0]);
+	size_t i = 0;
+	for (; i + 2 <= size; i += 2) {
+		__m128d v = _mm_loadu_pd(values + i);
+		best = max ? _mm_max_pd(v, best) : _mm_min_pd(v, best);
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, best);
+	return best_of<max>(lanes, 2, values, i, size);
+}
+
+static long sse2_find_int(const int* values, size_t size, int value) {
+	__m128i wanted = _mm_set1_epi32(value);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (values + i)), wanted));
+		if (mask) return i + __builtin_ctz(mask) / 4;
+	}
+	long found = scalar_find(values + i, size - i, value);
+	return found == -1 ? -1 : i + found;
+}
+
+static long sse2_find_real(const double* values, size_t size, double value) {
+	__m128d wanted = _mm_set1_pd(value);
+	size_t i = 0;
+	for (; i + 2 <= size; i += 2) {
+		int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(values + i), wanted));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+	long found = scalar_find(values + i, size - i, value);
+	return found == -1 ? -1 : i + found;
+}
+
+static void sse2_fill_ints(int* values, size_t size, int value) {
+	__m128i v = _mm_set1_epi32(value);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_si128((__m128i*) (values + i), v);
+	}
+	scalar_fill(values + i, size - i, value);
+}
+
+static void sse2_fill_reals(double* values, size_t size, double value) {
+	__m128d v = _mm_set1_pd(value);
+	size_t i = 0;
+	for (; i + 2 <= size; i += 2) {
+		_mm_storeu_pd(values + i, v);
+	}
+	scalar_fill(values + i, size - i, value);
+}
+
+static const ArrayKernels sse2_kernels = {
+	"sse2",
+	sse2_sum_ints, sse2_sum_reals,
+	sse2_best_int<true>, sse2_best_int<false>, sse2_best_real<true>, sse2_best_real<false>,
+	sse2_find_int, sse2_find_real,
+	sse2_fill_ints, sse2_fill_reals,
+	// SSE2 being the base of x86-64, the element-wise loops are already vectorized for it
+	scalar_map_ints, scalar_map_reals, scalar_zip_ints, scalar_zip_reals, scalar_to_reals
+};
+
+/*
+ * AVX2, compiled for it whatever the flags of the build, and only called
+ * when the processor supports it
+ */
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static double avx2_sum_ints(const int* values, size_t size) {
+	__m256i sum0 = _mm256_setzero_si256();
+	__m256i sum1 = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		sum0 = _mm256_add_epi64(sum0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*) (values + i))));
+		sum1 = _mm256_add_epi64(sum1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*) (values + i + 4))));
+	}
+	int64_t lanes[4];
+	_mm256_storeu_si256((__m256i*) lanes, _mm256_add_epi64(sum0, sum1));
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + (int64_t) scalar_sum_ints(values + i, size - i);
+}
+
+AVX2 static double avx2_sum_reals(const double* values, size_t size) {
+	__m256d sum0 = _mm256_setzero_pd();
+	__m256d sum1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(values + i));
+		sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(values + i + 4));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_sum_reals(values + i, size - i);
+}
+
+template <bool max>
+AVX2 static int avx2_best_int(const int* values, size_t size) {
+	if (size < 8) {
+		return max ? scalar_max(values, size) : scalar_min(values, size);
+	}
+	__m256i best = _mm256_loadu_si256((const __m256i*) values);
+	size_t i = 8;
+	for (; i + 8 <= size; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+		best = max ? _mm256_max_epi32(v, best) : _mm256_min_epi32(v, best);
+	}
+	int lanes[8];
+	_mm256_storeu_si256((__m256i*) lanes, best);
+	return best_of<max>(lanes, 8, values, i, size);
+}
+
+template <bool max>
+AVX2 static double avx2_best_real(const double* values, size_t size) {
+	if (size < 4) {
+		return max ? scalar_max(values, size) : scalar_min(values, size);
+	}
+	__m256d best = _mm256_set1_pd(values[0]);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		__m256d v = _mm256_loadu_pd(values + i);
+		best = max ? _mm256_max_pd(v, best) : _mm256_min_pd(v, best);
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, best);
+	return best_of<max>(lanes, 4, values, i, size);
+}
+
+AVX2 static long avx2_find_int(const int* values, size_t size, int value) {
+	__m256i wanted = _mm256_set1_epi32(value);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (values + i)), wanted));
+		if (mask) return i + __builtin_ctz(mask) / 4;
+	}
+	long found = scalar_find(values + i, size - i, value);
+	return found == -1 ? -1 : i + found;
+}
+
+AVX2 static long avx2_find_real(const double* values, size_t size, double value) {
+	__m256d wanted = _mm256_set1_pd(value);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), wanted, _CMP_EQ_OQ));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+	long found = scalar_find(values + i, size - i, value);
+	return found == -1 ? -1 : i + found;
+}
+
+AVX2 static void avx2_fill_ints(int* values, size_t size, int value) {
+	__m256i v = _mm256_set1_epi32(value);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		_mm256_storeu_si256((__m256i*) (values + i), v);
+	}
+	scalar_fill(values + i, size - i, value);
+}
+
+AVX2 static void avx2_fill_reals(double* values, size_t size, double value) {
+	__m256d v = _mm256_set1_pd(value);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm256_storeu_pd(values + i, v);
+	}
+	scalar_fill(values + i, size - i, value);
+}
+
+AVX2 static void avx2_map_ints(ArrayKernels::Operation op, int* result, const int* a, int b, size_t size) {
+	map_ints(op, result, a, b, size);
+}
+AVX2 static void avx2_map_reals(ArrayKernels::Operation op, double* result, const double* a, double b, size_t size) {
+	map_reals(op, result, a, b, size);
+}
+AVX2 static void avx2_zip_ints(ArrayKernels::Operation op, int* result, const int* a, const int* b, size_t size) {
+	zip_ints(op, result, a, b, size);
+}
+AVX2 static void avx2_zip_reals(ArrayKernels::Operation op, double* result, const double* a, const double* b, size_t size) {
+	zip_reals(op, result, a, b, size);
+}
+AVX2 static void avx2_to_reals(double* result, const int* values, size_t size) {
+	to_reals(result, values, size);
+}
+
+static const ArrayKernels avx2_kernels = {
+	"avx2",
+	avx2_sum_ints, avx2_sum_reals,
+	avx2_best_int<true>, avx2_best_int<false>, avx2_best_real<true>, avx2_best_real<false>,
+	avx2_find_int, avx2_find_real,
+	avx2_fill_ints, avx2_fill_reals,
+	avx2_map_ints, avx2_map_reals, avx2_zip_ints, avx2_zip_reals, avx2_to_reals
+};
+
+#endif
+
+vector<const ArrayKernels*> ArrayKernels::supported() {
+	vector<const ArrayKernels*> kernels = {&scalar_kernels};
+#if ARRAY_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) {
+		kernels.push_back(&sse2_kernels);
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		kernels.push_back(&avx2_kernels);
+	}
+#endif
+	return kernels;
+}
+
+const ArrayKernels& ArrayKernels::get() {
+	static const ArrayKernels& best = *supported().back();
+	return best;
+}
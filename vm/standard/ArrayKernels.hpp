@@ -0,0 +1,47 @@
+#ifndef VM_STANDARD_ARRAYKERNELS_HPP_
+#define VM_STANDARD_ARRAYKERNELS_HPP_
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Loops over the raw values of the unboxed arrays (reductions, search, fill
+ * and element-wise operations). They come in several versions : AVX2, SSE2 (always available on
+ * x86-64) and scalar for the other processors. The best one supported by
+ * the processor is chosen at the first use.
+ * The sums of reals are computed in several lanes : they can differ from a
+ * sequential sum in the last bits.
+ */
+class ArrayKernels {
+public:
+
+	enum Operation { ADD, SUB, MUL, DIV };
+
+	const char* name;
+
+	double (*sum_ints)(const int* values, size_t size);
+	double (*sum_reals)(const double* values, size_t size);
+	int (*max_ints)(const int* values, size_t size);
+	int (*min_ints)(const int* values, size_t size);
+	double (*max_reals)(const double* values, size_t size);
+	double (*min_reals)(const double* values, size_t size);
+	// Position of the first value equal, -1 if there's none
+	long (*find_int)(const int* values, size_t size, int value);
+	long (*find_real)(const double* values, size_t size, double value);
+	void (*fill_ints)(int* values, size_t size, int value);
+	void (*fill_reals)(double* values, size_t size, double value);
+	/*
+	 * result[i] = a[i] op b (map) or a[i] op b[i] (zip), the result can be one
+	 * of the operands. The integers wrap around, and are never divided.
+	 */
+	void (*map_ints)(Operation, int* result, const int* a, int b, size_t size);
+	void (*map_reals)(Operation, double* result, const double* a, double b, size_t size);
+	void (*zip_ints)(Operation, int* result, const int* a, const int* b, size_t size);
+	void (*zip_reals)(Operation, double* result, const double* a, const double* b, size_t size);
+	void (*to_reals)(double* result, const int* values, size_t size);
+
+	static const ArrayKernels& get();
+	static std::vector<const ArrayKernels*> supported();
+};
+
+#endif
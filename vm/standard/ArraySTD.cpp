@@ -1,7 +1,11 @@
 #include <algorithm>
+#include <functional>
+#include <climits>
+#include <cmath>
 #include "ArraySTD.hpp"
 #include "../value/LSArray.hpp"
 #include "../value/LSNumber.hpp"
+#include "ArrayKernels.hpp"
 
 using namespace std;
 
@@ -69,15 +73,37 @@ ArraySTD::ArraySTD() : Module("Array") {
 	method("removeElement", Type::ARRAY, {Type::ARRAY, Type::POINTER}, (void*)&array_removeElement);
 }
 
+/*
+ * Reductions of unboxed arrays run directly on their raw values (see ArrayKernels)
+ */
+static double sum_values(const LSArray* array) {
+	const ArrayKernels& kernels = ArrayKernels::get();
+	if (array->unboxed == RawType::INTEGER) {
+		return kernels.sum_ints(array->ints.data(), array->ints.size());
+	}
+	return kernels.sum_reals(array->reals.data(), array->reals.size());
+}
+
+static double best_value(const LSArray* array, bool max) {
+	const ArrayKernels& kernels = ArrayKernels::get();
+	if (array->unboxed == RawType::INTEGER) {
+		return (max ? kernels.max_ints : kernels.min_ints)(array->ints.data(), array->ints.size());
+	}
+	return (max ? kernels.max_reals : kernels.min_reals)(array->reals.data(), array->reals.size());
+}
+
 LSValue* array_average(const LSArray* array) {
-	if (array->values.size() == 0) {
+	if (array->size() == 0) {
 		return LSNumber::get(0);
 	}
+	if (array->unboxed != RawType::UNKNOWN) {
+		return LSNumber::get(sum_values(array) / array->size());
+	}
 	double avg = 0;
-	for (auto v : array->values) {
-		avg += ((LSNumber*) v.second)->value;
+	for (LSValue* v : *array) {
+		avg += ((LSNumber*) v)->value;
 	}
-	return LSNumber::get(avg / array->values.size());
+	return LSNumber::get(avg / array->size());
 }
 
 LSArray* array_concat(const LSArray* array1, const LSArray* array2) {
@@ -91,6 +117,23 @@ LSArray* array_clear(LSArray* array) {
 
 LSValue* array_fill(LSArray* array, const LSValue* value, const LSNumber* size) {
 	array->clear();
+	// Filled with a number : the array is unboxed
+	if (value->typeID() == 3 and size->value > 0) {
+		NUMBER_TYPE number = ((const LSNumber*) value)->value;
+		size_t count = size->value;
+		const ArrayKernels& kernels = ArrayKernels::get();
+		if (number >= INT_MIN and number <= INT_MAX and number == (int) number) {
+			array->unboxed = RawType::INTEGER;
+			array->ints.resize(count);
+			kernels.fill_ints(array->ints.data(), count, number);
+		} else {
+			array->unboxed = RawType::FLOAT;
+			array->reals.resize(count);
+			kernels.fill_reals(array->reals.data(), count, number);
+		}
+		array->index = count;
+		return array;
+	}
 	for (int i = 0; i < (int) size->value; i++) {
 		array->pushClone((LSValue*) value);
 	}
@@ -100,24 +143,31 @@ LSValue* array_fill(LSArray* array, const LSValue* value, const LSNumber* size)
 LSArray* array_filter(const LSArray* array, const LSFunction* function) {
 	LSArray* new_array = new LSArray();
 	auto fun = (void* (*)(void*))function->function;
-	if (array->associative) {
-		for (auto v : array->values) {
-			if (((LSValue*) fun(v.second))->isTrue()) new_array->pushKeyClone(v.first, v.second);
-		}
-	} else {
-		for (auto v : array->values) {
-			if (((LSValue*) fun(v.second))->isTrue()) new_array->pushClone(v.second);
+	for (auto v = array->begin(); v != array->end(); ++v) {
+		LSValue* r = (LSValue*) fun(*v);
+		if (r->isTrue()) {
+			if (array->associative) {
+				new_array->pushKeyClone(v.key(), *v);
+			} else {
+				new_array->pushClone(*v);
+			}
 		}
+		LSValue::delete_temporary(r);
 	}
 	return new_array;
 }
 
 LSValue* array_first(const LSArray* array) {
-	auto first = array->values.begin();
-	if (first == array->values.end()) {
+	if (array->size() == 0) {
 		return LSNull::null_var;
 	}
-	return first->second->clone();
+	if (array->unboxed == RawType::INTEGER) {
+		return LSNumber::get(array->ints.front());
+	}
+	if (array->unboxed == RawType::FLOAT) {
+		return LSNumber::get(array->reals.front());
+	}
+	return (*array->begin())->clone();
 }
 
 LSArray* array_flatten(const LSArray*, const LSNumber*) {
@@ -128,8 +178,8 @@ LSArray* array_flatten(const LSArray*, const LSNumber*) {
 LSValue* array_foldLeft(const LSArray* array, const LSFunction* function, LSValue* v0) {
 	auto fun = (LSValue* (*)(LSValue*, LSValue*)) function->function;
 	LSValue* result = v0;
-	for (auto v : array->values) {
-		result = fun(result, v.second);
+	for (LSValue* v : *array) {
+		result = fun(result, v);
 	}
 	return result;
 }
@@ -137,23 +187,33 @@ LSValue* array_foldLeft(const LSArray* array, const LSFunction* function, LSValu
 LSValue* array_foldRight(const LSArray* array, const LSFunction* function, LSValue* v0) {
 	auto fun = (LSValue* (*)(LSValue*, LSValue*)) function->function;
 	LSValue* result = v0;
-	for (auto it = array->values.rbegin(); it != array->values.rend(); it++) {
-		result = fun(it->second, result);
+	array->box();
+	if (array->associative) {
+		for (auto it = array->entries.rbegin(); it != array->entries.rend(); it++) {
+			result = fun(it->second, result);
+		}
+	} else {
+		for (auto it = array->list.rbegin(); it != array->list.rend(); it++) {
+			result = fun(*it, result);
+		}
 	}
 	return result;
 }
 
 LSValue* array_iter(const LSArray* array, const LSFunction* function) {
 	auto fun = (void* (*)(void*))function->function;
-	for (auto v : array->values) {
-		fun(v.second);
+	for (LSValue* v : *array) {
+		LSValue::delete_temporary((LSValue*) fun(v));
 	}
 	return LSNull::null_var;
 }
 
 LSValue* array_contains(const LSArray* array, const LSValue* value) {
-	for (auto v : array->values) {
-		if (value->operator == (v.second)) {
+	if (array->unboxed != RawType::UNKNOWN) {
+		return LSBoolean::get(array->in(value));
+	}
+	for (LSValue* v : *array) {
+		if (value->operator == (v)) {
 			return LSBoolean::true_val;
 		}
 	}
@@ -166,7 +226,10 @@ LSValue* array_insert(LSArray* array, const LSValue* element, const LSValue* ind
 			array->pushClone((LSValue*) element);
 		} else {
 			// TODO should move all elements after index to the right ? or replace the element
-			array->values[(LSValue*) index] = element->clone();
+			LSValue** slot = array->atL(index);
+			LSValue* old = *slot;
+			*slot = ((LSValue*) element)->clone_inc();
+			LSValue::delete_ref(old);
 		}
 	} else {
 		array->pushKeyClone((LSValue*) index, (LSValue*) element);
@@ -175,16 +238,21 @@ LSValue* array_insert(LSArray* array, const LSValue* element, const LSValue* ind
 }
 
 LSValue* array_isEmpty(const LSArray* array) {
-	return new LSBoolean(array->values.empty());
+	return new LSBoolean(array->size() == 0);
 }
 
 LSValue* array_join(const LSArray* array, const LSString* glue) {
-	if (array->values.empty())
+	if (array->size() == 0)
 		return new LSString();
-	auto it = array->values.begin();
-	LSValue* result = it->second->operator +(new LSString());
-	for (it++; it != array->values.end(); it++) {
-		result = it->second->operator +(glue->operator +(result));
+	auto it = array->begin();
+	LSString* empty = new LSString();
+	LSValue* result = (*it)->operator +(empty);
+	if (result != empty) delete empty;
+	for (++it; it != array->end(); ++it) {
+		LSValue* with_glue = glue->operator +(result);
+		if (with_glue != result) LSValue::delete_temporary(result);
+		result = (*it)->operator +(with_glue);
+		if (result != with_glue) LSValue::delete_temporary(with_glue);
 	}
 	return result;
 }
@@ -195,17 +263,22 @@ LSValue* array_keySort(const LSArray*, const LSNumber*) {
 }
 
 LSValue* array_last(const LSArray* array) {
-	auto last = array->values.rbegin();
-	if (last == array->values.rend())
+	if (array->size() == 0)
 		return LSNull::null_var;
-	return last->second->clone();
+	if (array->unboxed == RawType::INTEGER)
+		return LSNumber::get(array->ints.back());
+	if (array->unboxed == RawType::FLOAT)
+		return LSNumber::get(array->reals.back());
+	if (array->associative)
+		return array->entries.rbegin()->second->clone();
+	return array->list.back()->clone();
 }
 
 LSArray* array_map(const LSArray* array, const LSFunction* function) {
 	LSArray* new_array = new LSArray();
 	auto fun = (void* (*)(void*))function->function;
-	for (auto v : array->values) {
-		new_array->pushClone((LSValue*) fun(v.second));
+	for (LSValue* v : *array) {
+		new_array->pushMove((LSValue*) fun(v));
 	}
 	return new_array;
 }
@@ -213,43 +286,54 @@ LSArray* array_map(const LSArray* array, const LSFunction* function) {
 LSArray* array_map2(const LSArray* array, const LSArray* array2, const LSFunction* function) {
 	LSArray* new_array = new LSArray();
 	auto fun = (void* (*)(void*, void*))function->function;
-	for (auto v : array->values) {
-		LSValue* v2 = ((LSArray*) array2)->values[v.first];
-		new_array->pushClone((LSValue*) fun(v.second, v2));
+	LSNumber position(0);
+	for (auto v = array->begin(); v != array->end(); ++v) {
+		LSValue* key = v.key();
+		if (key == nullptr) {
+			position.value = v.position;
+			key = &position;
+		}
+		new_array->pushMove((LSValue*) fun(*v, array2->at(key)));
 	}
 	return new_array;
 }
 
 LSValue* array_max(const LSArray* array) {
-	if (array->values.size() == 0) {
+	if (array->size() == 0) {
 		return LSNumber::get(0);
 	}
-	auto it = array->values.begin();
-	double max = ((LSNumber*) it->second)->value;
-	it++;
-	while (it != array->values.end()) {
-		double val = ((LSNumber*) it->second)->value;
+	if (array->unboxed != RawType::UNKNOWN) {
+		return LSNumber::get(best_value(array, true));
+	}
+	auto it = array->begin();
+	double max = ((LSNumber*) *it)->value;
+	++it;
+	while (it != array->end()) {
+		double val = ((LSNumber*) *it)->value;
 		if (val > max) {
 			max = val;
 		}
-		it++;
+		++it;
 	}
 	return LSNumber::get(max);
 }
 
 LSValue* array_min(const LSArray* array) {
-	if (array->values.size() == 0) {
+	if (array->size() == 0) {
 		return LSNumber::get(0);
 	}
-	auto it = array->values.begin();
-	double min = ((LSNumber*) it->second)->value;
-	it++;
-	while (it != array->values.end()) {
-		double val = ((LSNumber*) it->second)->value;
+	if (array->unboxed != RawType::UNKNOWN) {
+		return LSNumber::get(best_value(array, false));
+	}
+	auto it = array->begin();
+	double min = ((LSNumber*) *it)->value;
+	++it;
+	while (it != array->end()) {
+		double val = ((LSNumber*) *it)->value;
 		if (val < min) {
 			min = val;
 		}
-		it++;
+		++it;
 	}
 	return LSNumber::get(min);
 }
@@ -259,18 +343,18 @@ LSValue* array_partition(const LSArray* array, const LSFunction* callback) {
 	LSArray* array_true = new LSArray();
 	LSArray* array_false = new LSArray();
 	auto fun = (void* (*)(void*))callback->function;
-	if (array->associative) {
-		for (auto v : array->values)
-			if (((LSValue *)fun(v.second))->isTrue()) array_true->pushKeyClone(v.first, v.second);
-			else array_false->pushKeyClone(v.first, v.second);
-
-	} else {
-		for (auto v : array->values)
-			if (((LSValue *)fun(v.second))->isTrue()) array_true->pushClone(v.second);
-			else array_false->pushClone(v.second);
+	for (auto v = array->begin(); v != array->end(); ++v) {
+		LSValue* r = (LSValue*) fun(*v);
+		LSArray* part = r->isTrue() ? array_true : array_false;
+		if (array->associative) {
+			part->pushKeyClone(v.key(), *v);
+		} else {
+			part->pushClone(*v);
+		}
+		LSValue::delete_temporary(r);
 	}
-	new_array->pushClone(array_true);
-	new_array->pushClone(array_false);
+	new_array->pushNoClone(array_true);
+	new_array->pushNoClone(array_false);
 	return new_array;
 }
 
@@ -285,8 +369,8 @@ LSValue* array_push(LSArray* array, LSValue* value) {
 
 LSValue* array_pushAll(LSArray* array, const LSArray* elements) {
 	if (not (array->associative and elements->associative)) {
-		for (auto i = elements->values.begin(); i != elements->values.end(); ++i) {
-			array->pushClone(i->second);
+		for (LSValue* v : *elements) {
+			array->pushClone(v);
 		}
 	}
 	return array;
@@ -301,12 +385,13 @@ LSValue* array_remove(LSArray* array, const LSValue* index) {
 }
 
 LSValue* array_removeElement(LSArray* array, const LSValue* element) {
-	for (auto i = array->values.begin(); i != array->values.end(); i++) {
-		if (i->second->operator ==(element)){
+	for (auto i = array->begin(); i != array->end(); ++i) {
+		if ((*i)->operator ==(element)){
 			if (array->associative) {
-				array->removeKey(i->first);
+				LSValue::delete_temporary(array->removeKey(i.key()));
 			} else {
-				array->remove((LSNumber*) i->first);
+				LSNumber position(i.position);
+				LSValue::delete_temporary(array->remove(&position));
 			}
 			break;
 		}
@@ -319,18 +404,44 @@ LSValue* array_removeKey(LSArray* array, const LSValue* index) {
 }
 
 LSValue* array_reverse(const LSArray* array) {
+	if (array->unboxed != RawType::UNKNOWN) {
+		return array->operator ~ ();
+	}
 	LSArray* new_array = new LSArray();
-	for (auto it = array->values.rbegin(); it != array->values.rend(); it++) {
-		new_array->pushClone(it->second);
+	if (array->associative) {
+		for (auto it = array->entries.rbegin(); it != array->entries.rend(); it++) {
+			new_array->pushClone(it->second);
+		}
+	} else {
+		for (auto it = array->list.rbegin(); it != array->list.rend(); it++) {
+			new_array->pushClone(*it);
+		}
 	}
 	return new_array;
 }
 
 LSValue* array_search(const LSArray* array, const LSValue* value, const LSValue* start) {
-	for (auto i = array->values.begin(); i != array->values.end(); i++) {
-		if (start->operator < (i->first)) continue; // i < start
-		if (value->operator == (i->second))
-			return i->first->clone();
+	// Numbers searched in an unboxed array from a position
+	if (array->unboxed != RawType::UNKNOWN and start->typeID() == 3) {
+		if (value->typeID() != 3) {
+			return LSNull::null_var;
+		}
+		// A start out of the array (or NaN) is converted to a position in it
+		double from = ceil(((const LSNumber*) start)->value);
+		from = std::isnan(from) ? 0 : min(max(0.0, from), (double) array->size());
+		long found = array->find_number(((const LSNumber*) value)->value, from);
+		return found == -1 ? LSNull::null_var : LSNumber::get(found);
+	}
+	LSNumber position(0);
+	for (auto i = array->begin(); i != array->end(); ++i) {
+		LSValue* key = i.key();
+		if (key == nullptr) {
+			position.value = i.position;
+			key = &position;
+		}
+		if (start->operator < (key)) continue; // i < start
+		if (value->operator == (*i))
+			return key->clone();
 	}
 	return LSNull::null_var;
 }
@@ -342,12 +453,12 @@ LSValue* array_shift(const LSArray*) {
 
 LSArray* array_shuffle(const LSArray* array) {
 	LSArray* new_array = new LSArray();
-	if (array->values.empty()) {
+	if (array->size() == 0) {
 		return new_array;
 	}
 	vector<LSValue*> shuffled_values;
-	for (auto it = array->values.begin(); it != array->values.end(); it++) {
-		shuffled_values.push_back(it->second);
+	for (LSValue* v : *array) {
+		shuffled_values.push_back(v);
 	}
 	random_shuffle(shuffled_values.begin(), shuffled_values.end());
 	for (auto it = shuffled_values.begin(); it != shuffled_values.end(); it++) {
@@ -357,7 +468,7 @@ LSArray* array_shuffle(const LSArray* array) {
 }
 
 LSNumber* array_size(const LSArray* array) {
-	return LSNumber::get(array->values.size());
+	return LSNumber::get(array->size());
 }
 
 LSArray* array_sort(const LSArray*, const LSNumber*) {
@@ -370,9 +481,12 @@ LSValue* array_subArray(const LSArray* array, const LSNumber* start, const LSNum
 }
 
 LSValue* array_sum(const LSArray* array) {
+	if (array->unboxed != RawType::UNKNOWN) {
+		return LSNumber::get(sum_values(array));
+	}
 	double sum = 0;
-	for (auto v : array->values) {
-		sum += ((LSNumber*) v.second)->value;
+	for (LSValue* v : *array) {
+		sum += ((LSNumber*) v)->value;
 	}
 	return LSNumber::get(sum);
 }
@@ -56,7 +56,9 @@ LSValue* string_map(const LSString* s, const LSFunction* function) {
 	std::string new_string = string("");
 	auto fun = (void* (*)(void*))function->function;
 	for (char v : s->value) {
-		new_string += ((LSString*) fun(new LSString(v)))->value;
+		LSString* r = (LSString*) fun(new LSString(v));
+		new_string += r->value;
+		LSValue::delete_temporary(r);
 	}
 	return new LSString(new_string);
 }
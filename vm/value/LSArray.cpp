@@ -4,53 +4,189 @@
 #include "LSFunction.hpp"
 #include "LSNumber.hpp"
 #include "LSBoolean.hpp"
+#include "LSObject.hpp"
 #include <algorithm>
+#include <cmath>
+#include <climits>
+#include "../standard/ArrayKernels.hpp"
 
 using namespace std;
 
-LSValue* LSArray::array_class(new LSClass("Array"));
+LSValue* LSArray::array_class(make_native(new LSClass("Array")));
 
 LSArray::LSArray() {
 	associative = false;
 	index = 0;
+	unboxed = RawType::UNKNOWN;
+}
+
+LSArray::LSArray(RawType unboxed) {
+	associative = false;
+	index = 0;
+	this->unboxed = unboxed;
 }
 
 LSArray::LSArray(initializer_list<LSValue*> values_list) {
 	associative = false;
 	index = 0;
+	unboxed = RawType::UNKNOWN;
 	for (auto i : values_list) {
-		LSValue** v = &this->values[new LSNumber(index++)];
-		*v = i;
+		pushNoClone(i);
 	}
 }
 
 LSArray::LSArray(initializer_list<pair<LSValue*, LSValue*>> values) {
 	associative = true;
 	index = 0;
+	unboxed = RawType::UNKNOWN;
 	for (auto i : values) {
-		if (i.first->isInteger()) {
-			index = max(index, (int) ((LSNumber*)i.first)->value + 1);
-		}
-		LSValue** v = &this->values[i.first];
-		*v = i.second;
+		pushKeyNoClone(i.first, i.second);
 	}
 }
 
 LSArray::LSArray(JsonValue& json) {
 	index = 0;
 	associative = false;
+	unboxed = RawType::UNKNOWN;
 
 	for (auto e : json) {
-		pushClone(LSValue::parse(e->value));
+		pushNoClone(LSValue::parse(e->value));
+	}
+}
+
+LSArray::~LSArray() {
+	for (auto v : list) {
+		LSValue::delete_ref(v);
+	}
+	for (auto v : entries) {
+		LSValue::delete_ref(v.first);
+		LSValue::delete_ref(v.second);
+	}
+}
+
+/*
+ * Insert a copy of the value, unless the key is already used
+ */
+static void insert_clone(LSArray* array, LSValue* key, const LSValue* value) {
+	if (array->entries.find(key) != array->entries.end()) {
+		LSValue::delete_temporary(key);
+		return;
+	}
+	LSValue::inc_refs(key);
+	array->entries.insert(pair<LSValue*, LSValue*>(key, ((LSValue*) value)->clone_inc()));
+}
+
+/*
+ * Set a copy of the value at the key, replacing the previous one
+ */
+static void set_clone(LSArray* array, LSValue* key, const LSValue* value) {
+	auto it = array->entries.find(key);
+	if (it != array->entries.end()) {
+		LSValue* old = it->second;
+		it->second = ((LSValue*) value)->clone_inc();
+		LSValue::delete_ref(old);
+		LSValue::delete_temporary(key);
+	} else {
+		LSValue::inc_refs(key);
+		array->entries.insert(pair<LSValue*, LSValue*>(key, ((LSValue*) value)->clone_inc()));
+	}
+}
+
+/*
+ * Position in the list designated by a key, -1 if it's not a valid one
+ */
+static int list_position(const LSArray* array, const LSValue* key) {
+	if (key->typeID() != 3) {
+		return -1;
+	}
+	NUMBER_TYPE value = ((const LSNumber*) key)->value;
+	int position = (int) value;
+	if (position != value or position < 0 or position >= (int) array->size()) {
+		return -1;
+	}
+	return position;
+}
+
+/*
+ * Append a number to the raw values of an unboxed array,
+ * false if it doesn't fit in them
+ */
+static bool push_unboxed(LSArray* array, LSValue* value) {
+	if (value->typeID() != 3) {
+		return false;
+	}
+	NUMBER_TYPE number = ((LSNumber*) value)->value;
+	if (array->unboxed == RawType::INTEGER) {
+		if (number != (int) number) {
+			return false;
+		}
+		array->ints.push_back((int) number);
+	} else {
+		array->reals.push_back(number);
+	}
+	array->index++;
+	LSValue::delete_temporary(value);
+	return true;
+}
+
+template <class T>
+static void box_values(LSValueList& list, vector<T, LSAllocator<T>>& values) {
+	list.reserve(values.size());
+	for (T v : values) {
+		LSValue* number = new LSNumber(v);
+		LSValue::inc_refs(number);
+		list.push_back(number);
+	}
+	vector<T, LSAllocator<T>>().swap(values);
+}
+
+void LSArray::box() const {
+	if (unboxed == RawType::INTEGER) {
+		box_values(list, ints);
+	} else if (unboxed == RawType::FLOAT) {
+		box_values(list, reals);
 	}
+	unboxed = RawType::UNKNOWN;
 }
 
-LSArray::~LSArray() {}
+void LSArray::to_associative() {
+	if (associative) {
+		return;
+	}
+	box();
+	associative = true;
+	for (size_t i = 0; i < list.size(); ++i) {
+		LSValue* key = LSNumber::get(i);
+		LSValue::inc_refs(key);
+		entries.insert(entries.end(), pair<LSValue*, LSValue*>(key, list[i]));
+	}
+	list.clear();
+}
+
+size_t LSArray::size() const {
+	if (unboxed == RawType::INTEGER) {
+		return ints.size();
+	}
+	if (unboxed == RawType::FLOAT) {
+		return reals.size();
+	}
+	return associative ? entries.size() : list.size();
+}
 
 void LSArray::clear() {
+	for (auto v : list) {
+		LSValue::delete_ref(v);
+	}
+	for (auto v : entries) {
+		LSValue::delete_ref(v.first);
+		LSValue::delete_ref(v.second);
+	}
 	associative = false;
 	index = 0;
-	values.clear();
+	list.clear();
+	entries.clear();
+	ints.clear();
+	reals.clear();
 }
 
 LSValue* LSArray::remove(LSNumber* index) {
@@ -60,37 +196,94 @@ LSValue* LSArray::remove(LSNumber* index) {
 }
 
 LSValue* LSArray::removeKey(LSValue* key) {
-	auto it = this->values.find(key);
-	if (it != this->values.end()) {
-		associative = true;
+	box();
+	if (!associative and list_position(this, key) == -1) {
+		return LSNull::null_var;
+	}
+	to_associative();
+	auto it = this->entries.find(key);
+	if (it != this->entries.end()) {
+		LSValue* k = it->first;
 		LSValue* val = it->second;
-		this->values.erase(it);
+		this->entries.erase(it);
+		LSValue::delete_ref(k);
+		// The removed value is given back to the caller as a temporary
+		LSValue::dec_refs(val);
 		return val;
 	}
 	return LSNull::null_var;
 }
 
 LSValue* LSArray::pop() {
-	auto last = this->values.rbegin();
-	if (last == this->values.rend())
+	if (size() == 0) {
 		return LSNull::null_var;
+	}
 	index--;
-	LSValue* val = last->second;
-	this->values.erase(last->first);
+	if (unboxed == RawType::INTEGER) {
+		int val = ints.back();
+		ints.pop_back();
+		return LSNumber::get(val);
+	}
+	if (unboxed == RawType::FLOAT) {
+		double val = reals.back();
+		reals.pop_back();
+		return LSNumber::get(val);
+	}
+	LSValue* val;
+	if (associative) {
+		auto last = std::prev(this->entries.end());
+		LSValue::delete_ref(last->first);
+		val = last->second;
+		this->entries.erase(last);
+	} else {
+		val = list.back();
+		list.pop_back();
+	}
+	LSValue::dec_refs(val);
 	return val;
 }
 
 void LSArray::pushNoClone(LSValue *value) {
 
+	if (unboxed != RawType::UNKNOWN) {
+		if (push_unboxed(this, value)) {
+			return;
+		}
+		box();
+	}
+
+	if (!associative) {
+		LSValue::inc_refs(value);
+		list.push_back(value);
+		index++;
+		return;
+	}
+
 	LSValue* key = LSNumber::get(index++);
-	LSValue* val = value;
 
-	this->values.insert(pair<LSValue*, LSValue*> (key, val));
+	auto r = this->entries.insert(pair<LSValue*, LSValue*> (key, value));
+	if (r.second) {
+		LSValue::inc_refs(key);
+		LSValue::inc_refs(value);
+	} else {
+		LSValue::delete_temporary(key);
+		LSValue::delete_temporary(value);
+	}
 }
 
 void LSArray::pushKeyNoClone(LSValue *key, LSValue *var) {
-	this->values[key] = var;
-	associative = true;
+	to_associative();
+	auto it = this->entries.find(key);
+	if (it != this->entries.end()) {
+		LSValue::inc_refs(var);
+		LSValue::delete_ref(it->second);
+		it->second = var;
+		LSValue::delete_temporary(key);
+	} else {
+		LSValue::inc_refs(key);
+		LSValue::inc_refs(var);
+		this->entries.insert(pair<LSValue*, LSValue*>(key, var));
+	}
 	if (key->isInteger()) {
 		index = max(index, (int) ((LSNumber*)key)->value + 1);
 	}
@@ -104,20 +297,22 @@ void LSArray::pushKeyClone(LSValue* key, LSValue* var) {
 	pushKeyNoClone(key, var->clone());
 }
 
-LSArrayIterator LSArray::begin() {
-	return values.begin();
+void LSArray::pushMove(LSValue* value) {
+	pushNoClone(value->move());
 }
 
-LSArrayIterator LSArray::end() {
-	return values.end();
+LSArrayIterator LSArray::begin() const {
+	box();
+	return LSArrayIterator(this, 0, entries.begin());
 }
 
-LSValue* LSArray::at(LSArrayIterator it) {
-	return it->second;
+LSArrayIterator LSArray::end() const {
+	box();
+	return LSArrayIterator(this, size(), entries.end());
 }
 
 bool LSArray::isTrue() const {
-	return values.size() > 0;
+	return size() > 0;
 }
 
 LSValue* LSArray::operator - () const {
@@ -125,13 +320,25 @@ LSValue* LSArray::operator - () const {
 }
 
 LSValue* LSArray::operator ! () const {
-	return LSBoolean::get(values.size() == 0);
+	return LSBoolean::get(size() == 0);
 }
 
 LSValue* LSArray::operator ~ () const {
+	if (unboxed != RawType::UNKNOWN) {
+		LSArray* array = (LSArray*) clone();
+		reverse(array->ints.begin(), array->ints.end());
+		reverse(array->reals.begin(), array->reals.end());
+		return array;
+	}
 	LSArray* array = new LSArray();
-	for (auto i = values.rbegin(); i != values.rend(); ++i) {
-		array->pushClone(i->second);
+	if (associative) {
+		for (auto i = entries.rbegin(); i != entries.rend(); ++i) {
+			array->pushClone(i->second);
+		}
+	} else {
+		for (auto i = list.rbegin(); i != list.rend(); ++i) {
+			array->pushClone(*i);
+		}
 	}
 	return array;
 }
@@ -158,67 +365,64 @@ LSValue* LSArray::operator + (const LSValue* v) const {
 
 LSValue* LSArray::operator + (const LSNull* nulll) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), (LSValue*)nulll));
+	newArray->pushClone((LSValue*) nulll);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSBoolean* boolean) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), boolean->clone()));
+	newArray->pushClone((LSValue*) boolean);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSNumber* number) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), number->clone()));
+	newArray->pushClone((LSValue*) number);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSString* string) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), string->clone()));
+	newArray->pushClone((LSValue*) string);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSArray* array) const {
 
-	LSArray* newArray = new LSArray();
-	newArray->associative = array->associative or associative;
-	newArray->index = 0;
+	LSArray* newArray = (LSArray*) clone();
 
-	for (auto i = values.begin(); i != values.end(); ++i) {
-		if (associative) {
-			newArray->values.insert(pair<LSValue*, LSValue*>(i->first, i->second->clone()));
-		} else {
-			newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), i->second->clone()));
+	if (newArray->unboxed != RawType::UNKNOWN and newArray->unboxed == array->unboxed) {
+		newArray->ints.insert(newArray->ints.end(), array->ints.begin(), array->ints.end());
+		newArray->reals.insert(newArray->reals.end(), array->reals.begin(), array->reals.end());
+		newArray->index += array->size();
+	} else if (array->associative) {
+		newArray->to_associative();
+		for (auto i = array->entries.begin(); i != array->entries.end(); ++i) {
+			insert_clone(newArray, i->first, i->second);
 		}
-	}
-	for (auto i = array->values.begin(); i != array->values.end(); ++i) {
-		if (array->associative) {
-			newArray->values.insert(pair<LSValue*, LSValue*>(i->first, i->second->clone()));
-		} else {
-			newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), i->second->clone()));
+	} else {
+		for (LSValue* v : *array) {
+			newArray->pushClone(v);
 		}
 	}
-
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSObject* object) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), (LSValue*) object));
+	newArray->pushClone((LSValue*) object);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSFunction* fun) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), (LSValue*) fun));
+	newArray->pushClone((LSValue*) fun);
 	return newArray;
 }
 
 LSValue* LSArray::operator + (const LSClass* clazz) const {
 	LSArray* newArray = (LSArray*) clone();
-	newArray->values.insert(pair<LSValue*, LSValue*>(LSNumber::get(newArray->index++), (LSValue*) clazz));
+	newArray->pushClone((LSValue*) clazz);
 	return newArray;
 }
 
@@ -255,13 +459,18 @@ LSValue* LSArray::operator += (const LSArray* array) {
 		arr = (LSArray*) array->clone();
 	}
 
-	for (auto i = arr->values.begin(); i != arr->values.end(); ++i) {
-		if (arr->associative) {
-			LSValue** v = &values[i->first];
-			*v = i->second;
-		} else {
-			LSValue** v = &values[LSNumber::get(index++)];
-			*v = i->second;
+	if (unboxed != RawType::UNKNOWN and unboxed == arr->unboxed) {
+		ints.insert(ints.end(), arr->ints.begin(), arr->ints.end());
+		reals.insert(reals.end(), arr->reals.begin(), arr->reals.end());
+		index += arr->size();
+	} else if (arr->associative) {
+		to_associative();
+		for (auto i = arr->entries.begin(); i != arr->entries.end(); ++i) {
+			set_clone(this, i->first, i->second);
+		}
+	} else {
+		for (LSValue* v : *arr) {
+			pushClone(v);
 		}
 	}
 
@@ -303,10 +512,31 @@ LSValue* LSArray::operator - (const LSBoolean*) const {
 LSValue* LSArray::operator - (const LSNumber* number) const {
 
 	LSArray* copy = (LSArray*) clone();
+	copy->box();
+
+	if (!associative) {
+		LSValueList kept;
+		for (LSValue* v : copy->list) {
+			if (v->operator == (number)) {
+				LSValue::delete_ref(v);
+			} else {
+				kept.push_back(v);
+			}
+		}
+		copy->list = kept;
+		copy->index = kept.size();
+		return copy;
+	}
 
-	for (auto i = copy->values.begin(); i != copy->values.end(); ++i) {
+	for (auto i = copy->entries.begin(); i != copy->entries.end(); ) {
 		if (i->second->operator == (number)) {
-			copy->values.erase(i);
+			LSValue* k = i->first;
+			LSValue* v = i->second;
+			i = copy->entries.erase(i);
+			LSValue::delete_ref(k);
+			LSValue::delete_ref(v);
+		} else {
+			++i;
 		}
 	}
 	return copy;
@@ -604,11 +834,14 @@ bool LSArray::operator == (const LSString*) const {
 }
 bool LSArray::operator == (const LSArray* v) const {
 
-	if (this->values.size() != v->values.size()) {
+	if (size() != v->size()) {
 		return false;
 	}
-	for (auto i = values.begin(), j = v->values.begin(); i != values.end(); i++, j++) {
-		if (i->second->operator != (j->second)) return false;
+	if (unboxed != RawType::UNKNOWN and unboxed == v->unboxed) {
+		return ints == v->ints and reals == v->reals;
+	}
+	for (auto i = begin(), j = v->begin(); i != end(); ++i, ++j) {
+		if ((*i)->operator != (*j)) return false;
 	}
 	return true;
 }
@@ -638,7 +871,7 @@ bool LSArray::operator < (const LSString*) const {
 	return false;
 }
 bool LSArray::operator < (const LSArray* v) const {
-	return this->values.size() < v->values.size();
+	return size() < v->size();
 }
 bool LSArray::operator < (const LSObject*) const {
 	return true;
@@ -666,7 +899,7 @@ bool LSArray::operator > (const LSString*) const {
 	return true;
 }
 bool LSArray::operator > (const LSArray* v) const {
-	return this->values.size() > v->values.size();
+	return size() > v->size();
 }
 bool LSArray::operator > (const LSObject*) const {
 	return false;
@@ -694,7 +927,7 @@ bool LSArray::operator <= (const LSString*) const {
 	return false;
 }
 bool LSArray::operator <= (const LSArray* v) const {
-	return this->values.size() <= v->values.size();
+	return size() <= v->size();
 }
 bool LSArray::operator <= (const LSObject*) const {
 	return true;
@@ -722,7 +955,7 @@ bool LSArray::operator >= (const LSString*) const {
 	return true;
 }
 bool LSArray::operator >= (const LSArray* v) const {
-	return this->values.size() >= v->values.size();
+	return size() >= v->size();
 }
 bool LSArray::operator >= (const LSObject*) const {
 	return false;
@@ -735,28 +968,69 @@ bool LSArray::operator >= (const LSClass*) const {
 }
 
 bool LSArray::in(const LSValue* key) const {
-	for (auto i = values.begin(); i != values.end(); i++) {
-		if (i->second->operator == (key)) {
+	if (unboxed != RawType::UNKNOWN) {
+		return key->typeID() == 3 and find_number(((const LSNumber*) key)->value) != -1;
+	}
+	for (LSValue* v : *this) {
+		if (v->operator == (key)) {
 			return true;
 		}
 	}
 	return false;
 }
 
+/*
+ * Position of a number in an unboxed array, from a position, -1 if it's not in it
+ */
+long LSArray::find_number(double value, size_t from) const {
+	const ArrayKernels& kernels = ArrayKernels::get();
+	long found = -1;
+	// NaN is equal to no number, and can't be converted to an integer
+	if (std::isnan(value)) {
+		return -1;
+	}
+	if (unboxed == RawType::INTEGER) {
+		if (from >= ints.size() or value < INT_MIN or value > INT_MAX or value != (int) value) {
+			return -1;
+		}
+		found = kernels.find_int(ints.data() + from, ints.size() - from, value);
+	} else {
+		if (from >= reals.size()) {
+			return -1;
+		}
+		found = kernels.find_real(reals.data() + from, reals.size() - from, value);
+	}
+	return found == -1 ? -1 : from + found;
+}
+
+/*
+ * The values of an unboxed array are read without boxing it : they're new
+ * numbers. The values changed in place (a[0] += 1) are accessed with atL.
+ */
 LSValue* LSArray::at(const LSValue* key) const {
-	try {
-		return (LSValue*) values.at((LSValue*) key);
-	} catch (exception& e) {
-		return LSNull::null_var;
+	if (unboxed != RawType::UNKNOWN) {
+		int position = list_position(this, key);
+		if (position == -1) {
+			return LSNull::null_var;
+		}
+		return LSNumber::get(unboxed == RawType::INTEGER ? ints[position] : reals[position]);
+	}
+	if (!associative) {
+		int position = list_position(this, key);
+		return position == -1 ? LSNull::null_var : list[position];
 	}
+	auto it = entries.find((LSValue*) key);
+	return it == entries.end() ? LSNull::null_var : it->second;
 }
 
 LSValue** LSArray::atL(const LSValue* key) {
-	try {
-		return (LSValue**) &values.at((LSValue*) key);
-	} catch (exception& e) {
-		return &LSNull::null_var;
+	box();
+	if (!associative) {
+		int position = list_position(this, key);
+		return position == -1 ? &LSNull::null_var : &list[position];
 	}
+	auto it = entries.find((LSValue*) key);
+	return it == entries.end() ? &LSNull::null_var : &it->second;
 }
 
 /*
@@ -764,9 +1038,27 @@ LSValue** LSArray::atL(const LSValue* key) {
  */
 LSValue* LSArray::range(const LSValue* start, const LSValue* end) const {
 
-	LSArray* range = new LSArray();
+	LSArray* range = new LSArray(unboxed);
+
+	if (!associative) {
+		if (start->typeID() == 3 and end->typeID() == 3) {
+			int first = max(0, (int) ceil(((LSNumber*) start)->value));
+			int last = min((int) size() - 1, (int) floor(((LSNumber*) end)->value));
+			for (int i = first; i <= last; ++i) {
+				if (unboxed == RawType::INTEGER) {
+					range->ints.push_back(ints[i]);
+				} else if (unboxed == RawType::FLOAT) {
+					range->reals.push_back(reals[i]);
+				} else {
+					range->pushClone(list[i]);
+				}
+			}
+			range->index = range->size();
+		}
+		return range;
+	}
 
-	for (auto i = values.begin(); i != values.end(); i++) {
+	for (auto i = entries.begin(); i != entries.end(); i++) {
 
 		if (i->first->operator < (end)) break; // i > end
 		if (start->operator < (i->first)) continue; // i < start
@@ -782,18 +1074,15 @@ LSValue* LSArray::rangeL(const LSValue*, const LSValue*) {
 
 LSValue* LSArray::attr(const LSValue* key) const {
 
-	if (key->operator == (new LSString("size"))) {
-		return LSNumber::get(this->values.size());
+	if (((LSString*) key)->value == "size") {
+		return LSNumber::get(size());
 	}
 	if (((LSString*) key)->value == "class") {
 		return getClass();
 	}
 
-	try {
-		return values.at((LSValue*) key);
-	} catch (exception& e) {
-		return LSNull::null_var;
-	}
+	auto it = entries.find((LSValue*) key);
+	return it == entries.end() ? LSNull::null_var : it->second;
 }
 
 LSValue** LSArray::attrL(const LSValue*) {
@@ -801,31 +1090,44 @@ LSValue** LSArray::attrL(const LSValue*) {
 }
 
 LSValue* LSArray::abso() const {
-	return LSNumber::get(values.size());
+	return LSNumber::get(size());
 }
 
 LSValue* LSArray::clone() const {
 
-	LSArray* newArray = new LSArray();
+	LSArray* newArray = new LSArray(unboxed);
 	newArray->associative = associative;
 	newArray->index = index;
+	newArray->ints = ints;
+	newArray->reals = reals;
 
-	for (auto i = values.begin(); i != values.end(); i++) {
-		LSValue** v = &newArray->values[i->first];
-		*v = i->second->clone();
+	newArray->list.reserve(list.size());
+	for (LSValue* v : list) {
+		newArray->list.push_back(v->clone_inc());
+	}
+	for (auto i = entries.begin(); i != entries.end(); i++) {
+		LSValue::inc_refs(i->first);
+		newArray->entries.insert(newArray->entries.end(), pair<LSValue*, LSValue*>(i->first, i->second->clone_inc()));
 	}
 	return newArray;
 }
 
 std::ostream& LSArray::print(std::ostream& os) const {
 	os << "[";
-	for (auto i = values.begin(); i != values.end(); i++) {
-		if (i != values.begin()) os << ", ";
+	if (unboxed != RawType::UNKNOWN) {
+		for (size_t i = 0; i < size(); ++i) {
+			if (i > 0) os << ", ";
+			LSNumber(unboxed == RawType::INTEGER ? ints[i] : reals[i]).print(os);
+		}
+		return os << "]";
+	}
+	for (auto i = begin(); i != end(); ++i) {
+		if (i.position > 0) os << ", ";
 		if (associative) {
-			i->first->print(os);
+			i.key()->print(os);
 			os << ": ";
 		}
-		i->second->print(os);
+		(*i)->print(os);
 	}
 	os << "]";
 	return os;
@@ -840,14 +1142,20 @@ std::string ReplaceAll(std::string str, const std::string& from, const std::stri
 	return str;
 }
 
-string LSArray::json() const {
-	string res = "[";
-	for (auto i = values.begin(); i != values.end(); i++) {
-		if (i != values.begin()) res += ",";
-		string json = i->second->to_json();
-		res += json;
+ostream& LSArray::json(ostream& os) const {
+	os << "[";
+	if (unboxed != RawType::UNKNOWN) {
+		for (size_t i = 0; i < size(); ++i) {
+			if (i > 0) os << ",";
+			LSNumber(unboxed == RawType::INTEGER ? ints[i] : reals[i]).to_json(os);
+		}
+		return os << "]";
+	}
+	for (auto i = begin(); i != end(); ++i) {
+		if (i.position > 0) os << ",";
+		(*i)->to_json(os);
 	}
-	return res + "]";
+	return os << "]";
 }
 
 LSValue* LSArray::getClass() const {
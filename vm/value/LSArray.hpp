@@ -10,6 +10,7 @@
 #include <iterator>
 
 #include "../LSValue.hpp"
+#include "../LSAllocator.hpp"
 #include "../../lib/gason.h"
 #include "LSClass.hpp"
 #include "../Type.hpp"
@@ -20,18 +21,38 @@ struct lsvalue_less {
 	}
 };
 
-typedef std::map<LSValue*, LSValue*>::iterator LSArrayIterator;
+class LSArrayIterator;
+
+typedef std::vector<LSValue*, LSAllocator<LSValue*>> LSValueList;
+typedef std::map<LSValue*, LSValue*, lsvalue_less, LSAllocator<std::pair<LSValue* const, LSValue*>>> LSValueMap;
 
 class LSArray : public LSValue {
 public:
 
-	std::map<LSValue*, LSValue*, lsvalue_less> values;
+	/*
+	 * A non associative array stores its values in a vector, the key of a value
+	 * being its position. It switches to the map of keys to values as soon as
+	 * a key is set explicitly or removed.
+	 */
+	mutable LSValueList list;
+	LSValueMap entries;
 	bool associative;
 	int index;
 
+	/*
+	 * Arrays of numbers proven homogeneous by the compiler are unboxed : their
+	 * values are stored raw in `ints` or `reals`, and boxed into the list the
+	 * first time they are needed as values (access by reference, iteration by
+	 * the natives). The reads and the foreach loops don't box them.
+	 */
+	mutable RawType unboxed;
+	mutable std::vector<int, LSAllocator<int>> ints;
+	mutable std::vector<double, LSAllocator<double>> reals;
+
 	static LSValue* array_class;
 
 	LSArray();
+	LSArray(RawType unboxed);
 	LSArray(std::initializer_list<LSValue*>);
 	LSArray(std::initializer_list<std::pair<LSValue*, LSValue*>>);
 	LSArray(JsonValue& data);
@@ -42,13 +63,17 @@ public:
 	void pushKeyNoClone(LSValue* key, LSValue* var);
 	void pushClone(LSValue* value);
 	void pushKeyClone(LSValue* key, LSValue* var);
+	void pushMove(LSValue* value);
 	void clear();
 	LSValue* remove(LSNumber* index);
 	LSValue* removeKey(LSValue* key);
 	LSValue* pop();
-	LSArrayIterator begin();
-	LSArrayIterator end();
-	LSValue* at(LSArrayIterator);
+	void to_associative();
+	void box() const;
+	size_t size() const;
+	long find_number(double value, size_t from = 0) const;
+	LSArrayIterator begin() const;
+	LSArrayIterator end() const;
 
 	// ***** //
 
@@ -248,7 +273,7 @@ public:
 	LSValue* abso() const override;
 
 	std::ostream& print(std::ostream& os) const override;
-	std::string json() const override;
+	std::ostream& json(std::ostream&) const override;
 
 	LSValue* clone() const override;
 
@@ -259,5 +284,49 @@ public:
 	int typeID() const override;
 };
 
+/*
+ * Iterates over the values of an array in order, whatever its storage
+ */
+class LSArrayIterator {
+public:
+
+	const LSArray* array;
+	size_t position;
+	LSValueMap::const_iterator entry;
+
+	LSArrayIterator(const LSArray* array, size_t position,
+		LSValueMap::const_iterator entry)
+		: array(array), position(position), entry(entry) {}
+
+	bool at_end() const {
+		return array->associative ? entry == array->entries.end() : position >= array->size();
+	}
+
+	LSValue* value() const {
+		return array->associative ? entry->second : array->list[position];
+	}
+
+	// Key of an associative array, nullptr for a list (the key is the position)
+	LSValue* key() const {
+		return array->associative ? entry->first : nullptr;
+	}
+
+	LSValue* operator * () const {
+		return value();
+	}
+
+	LSArrayIterator& operator ++ () {
+		if (array->associative) {
+			++entry;
+		}
+		++position;
+		return *this;
+	}
+
+	bool operator != (const LSArrayIterator& it) const {
+		return array->associative ? entry != it.entry : position != it.position;
+	}
+};
+
 
 #endif
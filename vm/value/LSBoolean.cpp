@@ -5,9 +5,9 @@
 
 using namespace std;
 
-LSValue* LSBoolean::boolean_class(new LSClass("Boolean"));
-LSBoolean* LSBoolean::false_val(new LSBoolean(false));
-LSBoolean* LSBoolean::true_val(new LSBoolean(true));
+LSValue* LSBoolean::boolean_class(make_native(new LSClass("Boolean")));
+LSBoolean* LSBoolean::false_val(make_native(new LSBoolean(false)));
+LSBoolean* LSBoolean::true_val(make_native(new LSBoolean(true)));
 
 LSBoolean* LSBoolean::get(bool value) {
 	return value ? true_val : false_val;
@@ -571,8 +571,8 @@ std::ostream& LSBoolean::print(std::ostream& os) const {
 	return os;
 }
 
-string LSBoolean::json() const {
-	return value ? "true" : "false";
+ostream& LSBoolean::json(ostream& os) const {
+	return os << (value ? "true" : "false");
 }
 
 LSValue* LSBoolean::getClass() const {
@@ -5,7 +5,7 @@
 
 using namespace std;
 
-LSValue* LSClass::class_class(new LSClass("Class"));
+LSValue* LSClass::class_class(make_native(new LSClass("Class")));
 
 LSClass::LSClass() : name("?") {
 	parent = nullptr;
@@ -594,8 +594,8 @@ std::ostream& LSClass::print(std::ostream& os) const {
 	return os;
 }
 
-string LSClass::json() const {
-	return "class";
+ostream& LSClass::json(ostream& os) const {
+	return os << "class";
 }
 
 LSValue* LSClass::getClass() const {
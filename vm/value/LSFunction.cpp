@@ -5,7 +5,7 @@
 
 using namespace std;
 
-LSClass* LSFunction::function_class = new LSClass("Function");
+LSClass* LSFunction::function_class = make_native(new LSClass("Function"));
 
 LSFunction::LSFunction(void* function) {
 	this->function = function;
@@ -562,8 +562,8 @@ std::ostream& LSFunction::print(std::ostream& os) const {
 	os << "<function>";
 	return os;
 }
-string LSFunction::json() const {
-	return "\"<function>\"";
+ostream& LSFunction::json(ostream& os) const {
+	return os << "\"<function>\"";
 }
 
 LSValue* LSFunction::getClass() const {
@@ -4,8 +4,8 @@
 
 using namespace std;
 
-LSValue* LSNull::null_var = new LSNull();
-LSClass* LSNull::null_class = new LSClass("Null");
+LSValue* LSNull::null_var = make_native(new LSNull());
+LSClass* LSNull::null_class = make_native(new LSClass("Null"));
 
 bool LSNull::isTrue() const {
 	return false;
@@ -553,8 +553,8 @@ std::ostream& LSNull::print(std::ostream& os) const {
 	os << "null";
 	return os;
 }
-string LSNull::json() const {
-	return "\"1|null\"";
+ostream& LSNull::json(ostream& os) const {
+	return os << "\"1|null\"";
 }
 
 LSValue* LSNull::getClass() const {
@@ -214,7 +214,7 @@ public:
 	LSValue* abso() const override;
 
 	std::ostream& print(std::ostream& os) const override;
-	std::string json() const override;
+	std::ostream& json(std::ostream&) const override;
 
 	LSValue* getClass() const override;
 
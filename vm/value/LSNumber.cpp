@@ -6,22 +6,26 @@
 
 using namespace std;
 
-LSClass* LSNumber::number_class = new LSClass("Number");
+LSClass* LSNumber::number_class = make_native(new LSClass("Number"));
 
 LSNumber* LSNumber::cache[CACHE_HIGH - CACHE_LOW + 1];
 
 void LSNumber::build_cache() {
+	if (cache[0] != nullptr) {
+		return;
+	}
 	for (int i = CACHE_LOW; i <= CACHE_HIGH; ++i) {
-		cache[-CACHE_LOW + i] = new LSNumber(i);
+		cache[-CACHE_LOW + i] = make_native(new LSNumber(i));
 	}
 }
 
+/*
+ * -0.0 is not the cached 0 : its sign is kept (1 / -0.0 is -inf)
+ */
 LSNumber* LSNumber::get(NUMBER_TYPE i) {
-#if USE_CACHE
-	if ((i == (int) i) and i >= CACHE_LOW and i <= CACHE_HIGH) {
+	if (i >= CACHE_LOW and i <= CACHE_HIGH and i == (int) i and (i != 0 or !signbit(i)) and cache[0] != nullptr) {
 		return cache[(int) (-CACHE_LOW + i)];
 	}
-#endif
 	return new LSNumber(i);
 }
 
@@ -50,30 +54,32 @@ LSValue* LSNumber::operator ~ () const {
 }
 
 LSValue* LSNumber::operator ++ () {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value + 1);
+	}
 	++value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator ++ (int) {
 	NUMBER_TYPE old = value;
-#if !USE_CACHE
-	++value;
-#endif
+	if (!native) {
+		++value;
+	}
 	return LSNumber::get(old);
 }
 
 LSValue* LSNumber::operator -- () {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value - 1);
+	}
 	--value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator -- (int) {
 	NUMBER_TYPE old = value;
-#if !USE_CACHE
-	--value;
-#endif
+	if (!native) {
+		--value;
+	}
 	return LSNumber::get(old);
 }
 
@@ -112,9 +118,10 @@ LSValue* LSNumber::operator += (const LSNull*) {
 	return this;
 }
 LSValue* LSNumber::operator += (const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value + number->value);
+	}
 	value += number->value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator += (const LSBoolean*) {
@@ -175,9 +182,10 @@ LSValue* LSNumber::operator -= (const LSBoolean*) {
 	return this->clone();
 }
 LSValue* LSNumber::operator -= (const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value - number->value);
+	}
 	value -= number->value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator -= (const LSString*) {
@@ -234,9 +242,10 @@ LSValue* LSNumber::operator *= (const LSBoolean* boolean) {
 	return LSNumber::get(value * boolean->value);
 }
 LSValue* LSNumber::operator *= (const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value * number->value);
+	}
 	value *= number->value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator *= (const LSString*) {
@@ -293,9 +302,10 @@ LSValue* LSNumber::operator /= (LSValue* value) const {
 }
 
 LSValue* LSNumber::operator /= (const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(value / number->value);
+	}
 	value /= number->value;
-#endif
 	return this;
 }
 LSValue* LSNumber::operator /= (const LSString*) {
@@ -352,9 +362,10 @@ LSValue* LSNumber::pow_eq(const LSBoolean* value) {
 	return value->pow_eq(this);
 }
 LSValue* LSNumber::pow_eq(const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(pow(value, number->value));
+	}
 	value = pow(value, number->value);
-#endif
 	return this;
 }
 LSValue* LSNumber::pow_eq(const LSString*) {
@@ -411,9 +422,10 @@ LSValue* LSNumber::operator %= (const LSBoolean*) {
 	return this->clone();
 }
 LSValue* LSNumber::operator %= (const LSNumber* number) {
-#if !USE_CACHE
+	if (native) {
+		return LSNumber::get(fmod(value, number->value));
+	}
 	value = fmod(value, number->value);
-#endif
 	return this;
 }
 LSValue* LSNumber::operator %= (const LSString*) {
@@ -610,7 +622,7 @@ LSValue* LSNumber::abso() const {
 }
 
 LSValue* LSNumber::clone() const {
-	return LSNumber::get(this->value);
+	return new LSNumber(this->value);
 }
 
 bool LSNumber::isInteger() const {
@@ -639,8 +651,8 @@ string LSNumber::toString() const {
 	append_dbl2str(s, value);
 	return s;
 }
-string LSNumber::json() const {
-	return toString();
+ostream& LSNumber::json(ostream& os) const {
+	return os << toString();
 }
 
 std::ostream& LSNumber::print(std::ostream& os) const {
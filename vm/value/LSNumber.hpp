@@ -9,20 +9,22 @@
 #include "../Type.hpp"
 
 #define NUMBER_TYPE double
-#define USE_CACHE 0
 #define CACHE_LOW -128
 #define CACHE_HIGH 1000
 
 class LSNumber : public LSValue {
 public:
 
-#if USE_CACHE
-	const NUMBER_TYPE value;
-#else
 	NUMBER_TYPE value;
-#endif
 
 	static LSClass* number_class;
+
+	/*
+	 * Small integers are shared native values, so that numbers converted to
+	 * pointers or produced by operations don't need an allocation. A shared
+	 * number is never modified in place : a copy is stored in variables and
+	 * containers (see clone()), and the operators give a new number.
+	 */
 	static LSNumber* cache[CACHE_HIGH - CACHE_LOW + 1];
 	static void build_cache();
 	static LSNumber* get(NUMBER_TYPE);
@@ -231,7 +233,7 @@ public:
 	LSValue* clone() const override;
 
 	std::ostream& print(std::ostream& os) const override;
-	std::string json() const override;
+	std::ostream& json(std::ostream&) const override;
 	std::string toString() const;
 
 	LSValue* getClass() const override;
@@ -5,7 +5,7 @@
 
 using namespace std;
 
-LSValue* LSObject::object_class(new LSClass("Object"));
+LSValue* LSObject::object_class(make_native(new LSClass("Object")));
 
 LSObject::LSObject() {
 	clazz = nullptr;
@@ -14,7 +14,7 @@ LSObject::LSObject() {
 LSObject::LSObject(initializer_list<pair<string, LSValue*>> values) {
 
 	for (auto i : values) {
-		this->values.insert(pair<string, LSValue*>(i.first, i.second->clone()));
+		this->values.insert(pair<string, LSValue*>(i.first, i.second->clone_inc()));
 	}
 	clazz = nullptr;
 }
@@ -31,10 +31,18 @@ LSObject::LSObject(JsonValue& json) {
 	}
 }
 
-LSObject::~LSObject() {}
+LSObject::~LSObject() {
+	for (auto v : values) {
+		LSValue::delete_ref(v.second);
+	}
+}
 
 void LSObject::addField(string name, LSValue* var) {
-	this->values.insert(pair<string, LSValue*>(name, var));
+	if (this->values.insert(pair<string, LSValue*>(name, var)).second) {
+		LSValue::inc_refs(var);
+	} else {
+		LSValue::delete_temporary(var);
+	}
 }
 
 bool LSObject::isTrue() const {
@@ -600,7 +608,7 @@ LSValue* LSObject::abso() const {
 LSValue* LSObject::clone() const {
 	LSObject* obj = new LSObject();
 	for (auto i = values.begin(); i != values.end(); i++) {
-		obj->values.insert(pair<string, LSValue*>(i->first, i->second->clone()));
+		obj->values.insert(pair<string, LSValue*>(i->first, i->second->clone_inc()));
 	}
 	return obj;
 }
@@ -618,15 +626,14 @@ std::ostream& LSObject::print(std::ostream& os) const {
 	return os;
 }
 
-string LSObject::json() const {
-	string res = "{";
+ostream& LSObject::json(ostream& os) const {
+	os << "{";
 	for (auto i = values.begin(); i != values.end(); i++) {
-		if (i != values.begin()) res += ",";
-		res += "\"" + i->first + "\":";
-		string json = i->second->to_json();
-		res += json;
+		if (i != values.begin()) os << ",";
+		json_string(os, i->first) << ":";
+		i->second->to_json(os);
 	}
-	return res + "}";
+	return os << "}";
 }
 
 LSValue* LSObject::getClass() const {
@@ -2,15 +2,19 @@
 #define LSOBJECT_HPP_
 
 #include "../LSValue.hpp"
+#include "../LSAllocator.hpp"
 #include "LSClass.hpp"
 #include "../../lib/gason.h"
 #include "../Type.hpp"
 
 class LSObject : public LSValue {
 
+	// Writes and reads the fields in the snapshots
+	friend class Context;
+
 private:
 
-	std::map<std::string, LSValue*> values;
+	std::map<std::string, LSValue*, std::less<std::string>, LSAllocator<std::pair<const std::string, LSValue*>>> values;
 	LSClass* clazz;
 
 public:
@@ -224,7 +228,7 @@ public:
 	LSValue* clone() const override;
 
 	std::ostream& print(std::ostream& os) const override;
-	std::string json() const override;
+	std::ostream& json(std::ostream&) const override;
 
 	LSValue* getClass() const override;
 
@@ -9,15 +9,33 @@
 
 using namespace std;
 
-LSValue* LSString::string_class(new LSClass("String"));
+LSValue* LSString::string_class(make_native(new LSClass("String")));
+
+/*
+ * Memory of the characters out of the string object, accounted in the
+ * execution (0 for the short strings stored inline)
+ */
+static size_t buffer_size(const string& value) {
+	const char* data = value.data();
+	bool inline_buffer = data >= (const char*) &value and data < (const char*) (&value + 1);
+	return inline_buffer ? 0 : value.capacity() + 1;
+}
 
 LSString::LSString() {}
 LSString::LSString(const char value) : value(string(1, value)) {}
-LSString::LSString(const char* value) : value(value) {}
-LSString::LSString(std::string value) : value(value) {}
-LSString::LSString(JsonValue& json) : value(json.toString()) {}
+LSString::LSString(const char* value) : value(value) {
+	LSValue::account(buffer_size(this->value));
+}
+LSString::LSString(std::string value) : value(value) {
+	LSValue::account(buffer_size(this->value));
+}
+LSString::LSString(JsonValue& json) : value(json.toString()) {
+	LSValue::account(buffer_size(value));
+}
 
-LSString::~LSString() {}
+LSString::~LSString() {
+	LSValue::release(buffer_size(value));
+}
 
 bool LSString::isTrue() const {
 	return value.size() > 0;
@@ -92,7 +110,9 @@ LSValue* LSString::operator += (const LSNumber*) {
 	return this;
 }
 LSValue* LSString::operator += (const LSString* string) {
+	LSValue::release(buffer_size(value));
 	this->value += string->value;
+	LSValue::account(buffer_size(value));
 	return this;
 }
 LSValue* LSString::operator += (const LSArray*) {
@@ -594,8 +614,8 @@ std::ostream& LSString::print(std::ostream& os) const {
 	os << "'" << value << "'";
 	return os;
 }
-string LSString::json() const {
-	return "\"" + value + "\"";
+ostream& LSString::json(ostream& os) const {
+	return json_string(os, value);
 }
 
 LSValue* LSString::clone() const {
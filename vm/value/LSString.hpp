@@ -220,7 +220,7 @@ public:
 	LSValue* clone() const override;
 
 	std::ostream& print(std::ostream& os) const;
-	std::string json() const override;
+	std::ostream& json(std::ostream&) const override;
 
 	LSValue* getClass() const override;
 